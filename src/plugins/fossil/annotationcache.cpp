@@ -0,0 +1,80 @@
+/**************************************************************************
+**  This file is part of Fossil VCS plugin for Qt Creator
+**
+**  Copyright (c) 2013 - 2020, Artur Shepilko, <qtc-fossil@nomadbyte.com>.
+**
+**  Based on Bazaar VCS plugin for Qt Creator by Hugues Delorme.
+**
+**  Permission is hereby granted, free of charge, to any person obtaining a copy
+**  of this software and associated documentation files (the "Software"), to deal
+**  in the Software without restriction, including without limitation the rights
+**  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+**  copies of the Software, and to permit persons to whom the Software is
+**  furnished to do so, subject to the following conditions:
+**
+**  The above copyright notice and this permission notice shall be included in
+**  all copies or substantial portions of the Software.
+**
+**  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+**  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+**  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+**  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+**  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+**  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+**  THE SOFTWARE.
+**************************************************************************/
+
+
+#include "annotationcache.h"
+
+#include <algorithm>
+
+namespace Fossil {
+namespace Internal {
+
+AnnotationCache::AnnotationCache(int capacity) :
+    m_capacity(capacity)
+{ }
+
+QSharedPointer<const BlameLines> AnnotationCache::find(const QString &file, const QString &revision)
+{
+    const QString entryKey = key(file, revision);
+
+    QMutexLocker locker(&m_mutex);
+    const auto it = std::find_if(m_entries.begin(), m_entries.end(), [&entryKey](const Entry &entry) {
+        return entry.key == entryKey;
+    });
+    if (it == m_entries.end())
+        return {};
+
+    m_entries.splice(m_entries.begin(), m_entries, it);
+    return m_entries.front().lines;
+}
+
+QSharedPointer<const BlameLines> AnnotationCache::insert(const QString &file, const QString &revision,
+                                                         const BlameLines &lines)
+{
+    const QString entryKey = key(file, revision);
+    const QSharedPointer<const BlameLines> sharedLines(new BlameLines(lines));
+
+    QMutexLocker locker(&m_mutex);
+    m_entries.remove_if([&entryKey](const Entry &entry) { return entry.key == entryKey; });
+    m_entries.push_front({entryKey, sharedLines});
+    while (int(m_entries.size()) > m_capacity)
+        m_entries.pop_back();
+    return sharedLines;
+}
+
+void AnnotationCache::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_entries.clear();
+}
+
+QString AnnotationCache::key(const QString &file, const QString &revision)
+{
+    return file + '@' + revision;
+}
+
+} // namespace Internal
+} // namespace Fossil
@@ -0,0 +1,80 @@
+/**************************************************************************
+**  This file is part of Fossil VCS plugin for Qt Creator
+**
+**  Copyright (c) 2013 - 2020, Artur Shepilko, <qtc-fossil@nomadbyte.com>.
+**
+**  Based on Bazaar VCS plugin for Qt Creator by Hugues Delorme.
+**
+**  Permission is hereby granted, free of charge, to any person obtaining a copy
+**  of this software and associated documentation files (the "Software"), to deal
+**  in the Software without restriction, including without limitation the rights
+**  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+**  copies of the Software, and to permit persons to whom the Software is
+**  furnished to do so, subject to the following conditions:
+**
+**  The above copyright notice and this permission notice shall be included in
+**  all copies or substantial portions of the Software.
+**
+**  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+**  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+**  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+**  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+**  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+**  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+**  THE SOFTWARE.
+**************************************************************************/
+
+
+#pragma once
+
+#include <QDate>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QString>
+#include <QVector>
+
+#include <list>
+
+namespace Fossil {
+namespace Internal {
+
+class BlameLine
+{
+public:
+    QString changeId;
+    QString user;
+    QDate date;
+    QString text;   // of the line in the annotated version
+};
+
+using BlameLines = QVector<BlameLine>;
+
+// Bounded LRU cache of the file blame, keyed by the file path and the check-out revision.
+// The blame of a committed revision never changes, the entries need no invalidation.
+// Thread-safe, filled from the query pool.
+
+class AnnotationCache
+{
+public:
+    explicit AnnotationCache(int capacity = 64);
+
+    QSharedPointer<const BlameLines> find(const QString &file, const QString &revision);
+    QSharedPointer<const BlameLines> insert(const QString &file, const QString &revision,
+                                            const BlameLines &lines);
+    void clear();
+
+private:
+    struct Entry {
+        QString key;
+        QSharedPointer<const BlameLines> lines;
+    };
+
+    static QString key(const QString &file, const QString &revision);
+
+    const int m_capacity;
+    QMutex m_mutex;
+    std::list<Entry> m_entries; // most recently used first
+};
+
+} // namespace Internal
+} // namespace Fossil
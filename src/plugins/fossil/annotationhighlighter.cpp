@@ -25,27 +25,116 @@
 **************************************************************************/
 
 #include "annotationhighlighter.h"
-#include "constants.h"
 
-#include <utils/qtcassert.h>
+#include <texteditor/fontsettings.h>
+#include <texteditor/texteditorconstants.h>
+#include <texteditor/texteditorsettings.h>
+
+#include <QTextBlock>
 
 namespace Fossil {
 namespace Internal {
 
+void AnnotationLineChanges::clear()
+{
+    m_lineChanges.clear();
+    m_changes.clear();
+}
+
+void AnnotationLineChanges::setChange(int line, const QString &change)
+{
+    if (line < 0)
+        return;
+    if (line >= m_lineChanges.size())
+        m_lineChanges.resize(line + 1);
+
+    auto it = m_changes.constFind(change);
+    if (it == m_changes.constEnd())
+        it = m_changes.insert(change);
+    m_lineChanges[line] = *it;
+}
+
+QString AnnotationLineChanges::change(int line) const
+{
+    return m_lineChanges.value(line);
+}
+
+int AnnotationLineChanges::changeIdLength(const QString &line)
+{
+    // "<hash> <...>", same as Constants::CHANGESET_ID at the line start
+    const int size = qMin(line.size(), 41);
+    int length = 0;
+    for (; length < size; ++length) {
+        const ushort c = line.at(length).unicode();
+        if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f')))
+            break;
+    }
+    if (length < 5 || length > 40 || length == line.size() || line.at(length) != ' ')
+        return 0;
+    return length;
+}
+
 FossilAnnotationHighlighter::FossilAnnotationHighlighter(const ChangeNumbers &changeNumbers,
                                                          QTextDocument *document) :
-    VcsBase::BaseAnnotationHighlighter(changeNumbers, document),
-    m_changesetIdPattern(Constants::CHANGESET_ID)
+    VcsBase::BaseAnnotationHighlighter(changeNumbers, document)
 {
-    QTC_CHECK(m_changesetIdPattern.isValid());
+}
+
+void FossilAnnotationHighlighter::setLineChanges(
+        const QSharedPointer<const AnnotationLineChanges> &lineChanges)
+{
+    m_lineChanges = lineChanges;
+}
+
+void FossilAnnotationHighlighter::setStreaming(bool streaming)
+{
+    m_isStreaming = streaming;
+    m_streamingFormats.clear();
+    if (streaming) {
+        const QTextCharFormat textFormat = TextEditor::TextEditorSettings::fontSettings()
+                .toTextCharFormat(TextEditor::C_TEXT);
+        m_streamingBackground = textFormat.background().style() == Qt::NoBrush
+                ? QColor(Qt::white) : textFormat.background().color();
+    }
+}
+
+void FossilAnnotationHighlighter::highlightBlock(const QString &text)
+{
+    if (!m_isStreaming) {
+        VcsBase::BaseAnnotationHighlighter::highlightBlock(text);
+        return;
+    }
+
+    const QString change = changeNumber(text);
+    if (!change.isEmpty())
+        setFormat(0, text.length(), streamingFormat(change));
+}
+
+QTextCharFormat FossilAnnotationHighlighter::streamingFormat(const QString &change)
+{
+    // Stable per change, spread over the hues and readable on the background
+    auto it = m_streamingFormats.find(change);
+    if (it == m_streamingFormats.end()) {
+        const bool isDarkBackground = m_streamingBackground.lightness() < 128;
+        QTextCharFormat format;
+        format.setForeground(QColor::fromHsl(int(qHash(change) % 360), 200,
+                                             isDarkBackground ? 170 : 90));
+        it = m_streamingFormats.insert(change, format);
+    }
+    return it.value();
 }
 
 QString FossilAnnotationHighlighter::changeNumber(const QString &block) const
 {
-    QRegularExpressionMatch changesetIdMatch = m_changesetIdPattern.match(block);
-    if (changesetIdMatch.hasMatch())
-        return changesetIdMatch.captured(1);
-    return QString();
+    // The table is checked against the text, should the two ever disagree
+    if (m_lineChanges) {
+        const QString change = m_lineChanges->change(currentBlock().blockNumber());
+        if (!change.isEmpty() && block.startsWith(change))
+            return change;
+    }
+
+    const int length = AnnotationLineChanges::changeIdLength(block);
+    return length > 0 ? block.left(length) : QString();
 }
 
 } // namespace Internal
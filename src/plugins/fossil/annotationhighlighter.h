@@ -27,20 +27,58 @@
 #pragma once
 
 #include <vcsbase/baseannotationhighlighter.h>
-#include <QRegularExpression>
+
+#include <QHash>
+#include <QSet>
+#include <QSharedPointer>
+#include <QString>
+#include <QTextCharFormat>
+#include <QVector>
 
 namespace Fossil {
 namespace Internal {
 
+// Change ids of the annotation lines, by line number, extracted once as the
+// output is taken in. The lines of the same change share the id string.
+
+class AnnotationLineChanges
+{
+public:
+    void clear();
+    void setChange(int line, const QString &change);
+    // Empty when the line is not known, or not annotated
+    QString change(int line) const;
+    const QSet<QString> &changes() const { return m_changes; }
+
+    // Length of the change id leading the annotation line, 0 if none
+    static int changeIdLength(const QString &line);
+
+private:
+    QVector<QString> m_lineChanges;
+    QSet<QString> m_changes;
+};
+
 class FossilAnnotationHighlighter : public VcsBase::BaseAnnotationHighlighter
 {
 public:
     explicit FossilAnnotationHighlighter(const ChangeNumbers &changeNumbers,
                                          QTextDocument *document = nullptr);
 
+    // The lines not in the table are scanned for their change id
+    void setLineChanges(const QSharedPointer<const AnnotationLineChanges> &lineChanges);
+    // While the annotation streams in, each line takes a color of its own change at once.
+    // The colors of the base highlighter depend on the complete set of changes.
+    void setStreaming(bool streaming);
+
 private:
+    void highlightBlock(const QString &text) final;
     QString changeNumber(const QString &block) const final;
-    QRegularExpression m_changesetIdPattern;
+    QTextCharFormat streamingFormat(const QString &change);
+
+    QSharedPointer<const AnnotationLineChanges> m_lineChanges;
+    bool m_isStreaming = false;
+    QColor m_streamingBackground;
+    QHash<QString, QTextCharFormat> m_streamingFormats;
 };
 
 } // namespace Internal
@@ -0,0 +1,195 @@
+/**************************************************************************
+**  This file is part of Fossil VCS plugin for Qt Creator
+**
+**  Copyright (c) 2013 - 2020, Artur Shepilko, <qtc-fossil@nomadbyte.com>.
+**
+**  Based on Bazaar VCS plugin for Qt Creator by Hugues Delorme.
+**
+**  Permission is hereby granted, free of charge, to any person obtaining a copy
+**  of this software and associated documentation files (the "Software"), to deal
+**  in the Software without restriction, including without limitation the rights
+**  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+**  copies of the Software, and to permit persons to whom the Software is
+**  furnished to do so, subject to the following conditions:
+**
+**  The above copyright notice and this permission notice shall be included in
+**  all copies or substantial portions of the Software.
+**
+**  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+**  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+**  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+**  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+**  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+**  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+**  THE SOFTWARE.
+**************************************************************************/
+
+
+#include "artifactcache.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
+namespace Fossil {
+namespace Internal {
+
+ArtifactCache::ArtifactCache(const QString &directory) :
+    m_directory(directory)
+{ }
+
+void ArtifactCache::setMaxSize(qint64 maxSize)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_maxSize == maxSize)
+        return;
+    m_maxSize = maxSize;
+    if (m_isLoaded)
+        evict();
+}
+
+qint64 ArtifactCache::size() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_size;
+}
+
+bool ArtifactCache::find(const QString &hash, QByteArray *content)
+{
+    if (!isArtifactHash(hash))
+        return false;
+
+    QMutexLocker locker(&m_mutex);
+    if (m_maxSize <= 0)
+        return false;
+    load();
+
+    const auto indexIt = m_index.constFind(hash.toLower());
+    if (indexIt == m_index.constEnd())
+        return false;
+
+    const Entries::iterator it = indexIt.value();
+    QFile file(filePath(it->hash));
+    if (!file.open(QIODevice::ReadOnly) || file.size() != it->size) {
+        // removed or damaged behind our back
+        remove(it);
+        return false;
+    }
+    *content = file.readAll();
+
+    // The recency survives the restarts as the file time
+    file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+    m_entries.splice(m_entries.begin(), m_entries, it);
+    return true;
+}
+
+void ArtifactCache::insert(const QString &hash, const QByteArray &content)
+{
+    if (!isArtifactHash(hash))
+        return;
+
+    QMutexLocker locker(&m_mutex);
+    if (m_maxSize <= 0 || content.size() > m_maxSize)
+        return;
+    load();
+
+    const QString key = hash.toLower();
+    const auto indexIt = m_index.constFind(key);
+    if (indexIt != m_index.constEnd())
+        remove(indexIt.value());
+
+    const QString path = filePath(key);
+    if (!QDir().mkpath(QFileInfo(path).absolutePath()))
+        return;
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(content) != content.size() || !file.commit())
+        return;
+
+    m_entries.push_front({key, content.size()});
+    m_index.insert(key, m_entries.begin());
+    m_size += content.size();
+    evict();
+}
+
+void ArtifactCache::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    QDir(m_directory).removeRecursively();
+    m_entries.clear();
+    m_index.clear();
+    m_size = 0;
+    m_isLoaded = true;
+}
+
+bool ArtifactCache::isArtifactHash(const QString &hash)
+{
+    if (hash.size() != 40 && hash.size() != 64)
+        return false;
+    return std::all_of(hash.cbegin(), hash.cend(), [](QChar c) {
+        const ushort u = c.unicode();
+        return (u >= '0' && u <= '9') || (u >= 'a' && u <= 'f') || (u >= 'A' && u <= 'F');
+    });
+}
+
+QString ArtifactCache::filePath(const QString &hash) const
+{
+    // "ab/abcdef...", to keep the directories small
+    return m_directory + '/' + hash.left(2) + '/' + hash;
+}
+
+void ArtifactCache::load()
+{
+    // The entries left by the earlier sessions, most recently used first
+    if (m_isLoaded)
+        return;
+    m_isLoaded = true;
+
+    struct Found {
+        QString hash;
+        qint64 size;
+        QDateTime lastModified;
+    };
+    std::vector<Found> found;
+
+    QDirIterator it(m_directory, QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        it.next();
+        const QFileInfo fileInfo = it.fileInfo();
+        if (isArtifactHash(fileInfo.fileName()))
+            found.push_back({fileInfo.fileName(), fileInfo.size(), fileInfo.lastModified()});
+    }
+    std::sort(found.begin(), found.end(), [](const Found &a, const Found &b) {
+        return a.lastModified > b.lastModified;
+    });
+
+    for (const Found &entry : found) {
+        m_entries.push_back({entry.hash, entry.size});
+        m_index.insert(entry.hash, std::prev(m_entries.end()));
+        m_size += entry.size;
+    }
+    evict();
+}
+
+void ArtifactCache::remove(Entries::iterator it)
+{
+    QFile::remove(filePath(it->hash));
+    m_size -= it->size;
+    m_index.remove(it->hash);
+    m_entries.erase(it);
+}
+
+void ArtifactCache::evict()
+{
+    while (m_size > m_maxSize && !m_entries.empty())
+        remove(std::prev(m_entries.end()));
+}
+
+} // namespace Internal
+} // namespace Fossil
@@ -0,0 +1,85 @@
+/**************************************************************************
+**  This file is part of Fossil VCS plugin for Qt Creator
+**
+**  Copyright (c) 2013 - 2020, Artur Shepilko, <qtc-fossil@nomadbyte.com>.
+**
+**  Based on Bazaar VCS plugin for Qt Creator by Hugues Delorme.
+**
+**  Permission is hereby granted, free of charge, to any person obtaining a copy
+**  of this software and associated documentation files (the "Software"), to deal
+**  in the Software without restriction, including without limitation the rights
+**  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+**  copies of the Software, and to permit persons to whom the Software is
+**  furnished to do so, subject to the following conditions:
+**
+**  The above copyright notice and this permission notice shall be included in
+**  all copies or substantial portions of the Software.
+**
+**  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+**  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+**  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+**  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+**  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+**  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+**  THE SOFTWARE.
+**************************************************************************/
+
+
+
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+
+#include <list>
+
+namespace Fossil {
+namespace Internal {
+
+// Content-addressed disk cache of the repository artifacts, keyed by the full artifact hash.
+// An artifact never changes, the entries need no invalidation. The output derived from
+// the artifacts alone is kept as well, under the hash of what it is derived from.
+// The least recently used entries are evicted once the cache grows over its size limit.
+// Thread-safe, filled from the query pool.
+
+class ArtifactCache
+{
+public:
+    explicit ArtifactCache(const QString &directory);
+
+    // Zero disables the cache
+    void setMaxSize(qint64 maxSize);
+    qint64 size() const;
+
+    bool find(const QString &hash, QByteArray *content);
+    void insert(const QString &hash, const QByteArray &content);
+    void clear();
+
+    // Only the full SHA1 and SHA3-256 hashes identify an artifact for sure
+    static bool isArtifactHash(const QString &hash);
+
+private:
+    struct Entry {
+        QString hash;
+        qint64 size;
+    };
+    using Entries = std::list<Entry>;
+
+    QString filePath(const QString &hash) const;
+    void load();
+    void remove(Entries::iterator it);
+    void evict();
+
+    const QString m_directory;
+    mutable QMutex m_mutex;
+    qint64 m_maxSize = 0;
+    qint64 m_size = 0;
+    bool m_isLoaded = false;
+    Entries m_entries; // most recently used first
+    QHash<QString, Entries::iterator> m_index;
+};
+
+} // namespace Internal
+} // namespace Fossil
@@ -0,0 +1,190 @@
+/**************************************************************************
+**  This file is part of Fossil VCS plugin for Qt Creator
+**
+**  Copyright (c) 2013 - 2020, Artur Shepilko, <qtc-fossil@nomadbyte.com>.
+**
+**  Based on Bazaar VCS plugin for Qt Creator by Hugues Delorme.
+**
+**  Permission is hereby granted, free of charge, to any person obtaining a copy
+**  of this software and associated documentation files (the "Software"), to deal
+**  in the Software without restriction, including without limitation the rights
+**  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+**  copies of the Software, and to permit persons to whom the Software is
+**  furnished to do so, subject to the following conditions:
+**
+**  The above copyright notice and this permission notice shall be included in
+**  all copies or substantial portions of the Software.
+**
+**  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+**  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+**  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+**  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+**  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+**  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+**  THE SOFTWARE.
+**************************************************************************/
+
+
+#include "autopullscheduler.h"
+#include "fossilclient.h"
+#include "outputparser.h"
+
+#include <utils/qtcassert.h>
+#include <vcsbase/vcscommand.h>
+
+#include <QElapsedTimer>
+#include <QSharedPointer>
+
+namespace Fossil {
+namespace Internal {
+
+// Cap of the retry delay of a failing repository, in intervals
+const int maxBackoffIntervals = 16;
+// Check for the due repositories at least this often
+const int maxCheckDelayMs = 60 * 1000;
+
+AutoPullScheduler::AutoPullScheduler(FossilClient *client, QObject *parent) : QObject(parent),
+    m_client(client)
+{
+    QTC_CHECK(m_client);
+
+    m_timer.setSingleShot(true);
+    connect(&m_timer, &QTimer::timeout, this, &AutoPullScheduler::pullDue);
+}
+
+AutoPullScheduler::~AutoPullScheduler() = default;
+
+void AutoPullScheduler::setInterval(int minutes)
+{
+    const qint64 intervalMs = qMax(0, minutes) * 60 * qint64(1000);
+    if (intervalMs == m_intervalMs)
+        return;
+
+    m_intervalMs = intervalMs;
+    // Start over with the new interval
+    const QDateTime now = QDateTime::currentDateTimeUtc();
+    for (Repository &repository : m_repositories)
+        repository.nextPull = now.addMSecs(m_intervalMs);
+    schedule();
+}
+
+void AutoPullScheduler::setCheckouts(const QStringList &topLevels)
+{
+    QHash<QString, Repository> repositories;
+    const QDateTime now = QDateTime::currentDateTimeUtc();
+    for (const QString &topLevel : topLevels) {
+        const QString key = m_client->repositoryKey(topLevel);
+        Repository &repository = repositories[key];
+        if (repository.topLevels.isEmpty()) {
+            // Keep the state of the known repositories, pull the new ones soon
+            const auto known = m_repositories.constFind(key);
+            if (known != m_repositories.constEnd()) {
+                repository.statistics = known->statistics;
+                repository.nextPull = known->nextPull;
+                repository.running = known->running;
+            } else {
+                repository.nextPull = now;
+            }
+        }
+        if (!repository.topLevels.contains(topLevel))
+            repository.topLevels.append(topLevel);
+    }
+    m_repositories = repositories;
+    schedule();
+}
+
+QHash<QString, AutoPullScheduler::Statistics> AutoPullScheduler::statistics() const
+{
+    QHash<QString, Statistics> statistics;
+    for (auto it = m_repositories.cbegin(), end = m_repositories.cend(); it != end; ++it)
+        statistics.insert(it.key(), it->statistics);
+    return statistics;
+}
+
+void AutoPullScheduler::schedule()
+{
+    if (m_intervalMs <= 0 || m_repositories.isEmpty()) {
+        m_timer.stop();
+        return;
+    }
+
+    QDateTime nextPull;
+    for (const Repository &repository : qAsConst(m_repositories)) {
+        if (!repository.running && (!nextPull.isValid() || repository.nextPull < nextPull))
+            nextPull = repository.nextPull;
+    }
+    if (!nextPull.isValid()) {
+        m_timer.stop();
+        return;
+    }
+
+    const qint64 delayMs = QDateTime::currentDateTimeUtc().msecsTo(nextPull);
+    m_timer.start(int(qBound(qint64(0), delayMs, qint64(maxCheckDelayMs))));
+}
+
+void AutoPullScheduler::pullDue()
+{
+    const QDateTime now = QDateTime::currentDateTimeUtc();
+    for (auto it = m_repositories.begin(), end = m_repositories.end(); it != end; ++it) {
+        if (!it->running && it->nextPull <= now)
+            pull(it.key(), it.value());
+    }
+    schedule();
+}
+
+void AutoPullScheduler::pull(const QString &key, Repository &repository)
+{
+    QTC_ASSERT(!repository.topLevels.isEmpty(), return);
+
+    // Queued as a bulk job in the slot of the check-out, behind the interactive commands
+    repository.running = true;
+    const QString topLevel = repository.topLevels.first();
+    const auto progress = QSharedPointer<SyncProgress>::create();
+    const auto timer = QSharedPointer<QElapsedTimer>::create();
+
+    VcsBase::VcsCommand *cmd = m_client->createCommand(topLevel);
+    cmd->addFlags(VcsBase::VcsCommand::NoOutput);
+    connect(cmd, &VcsBase::VcsCommand::started, this, [timer] { timer->start(); });
+    connect(cmd, &VcsBase::VcsCommand::stdOutText, this, [progress](const QString &text) {
+        OutputParser::parseSyncProgress(text, progress.data());
+    });
+    connect(cmd, &VcsBase::VcsCommand::finished, this, [this, key, progress, timer](bool ok) {
+        auto it = m_repositories.find(key);
+        if (it == m_repositories.end())
+            return;
+
+        ok = ok && progress->isDone;
+        const QDateTime now = QDateTime::currentDateTimeUtc();
+        it->running = false;
+        if (ok) {
+            it->statistics.lastSync = now;
+            it->statistics.lastLatencyMs = timer->isValid() ? timer->elapsed() : 0;
+            it->statistics.lastBytesReceived = progress->bytesReceived;
+            it->statistics.lastArtifactsReceived = progress->artifactsReceived;
+            it->statistics.failureCount = 0;
+            it->nextPull = now.addMSecs(m_intervalMs);
+        } else {
+            ++it->statistics.failureCount;
+            it->nextPull = now.addMSecs(retryDelayMs(it->statistics.failureCount));
+        }
+
+        if (ok && progress->artifactsReceived > 0) {
+            for (const QString &checkout : qAsConst(it->topLevels))
+                emit m_client->changed(QVariant(checkout));
+        }
+        if (ok)
+            emit pulled(key);
+        schedule();
+    });
+    m_client->enqueueFossilJob(cmd, {"pull"}, JobScheduler::Bulk);
+}
+
+qint64 AutoPullScheduler::retryDelayMs(int failureCount) const
+{
+    // One, two, four... intervals
+    const int intervals = 1 << qMin(failureCount - 1, 30);
+    return m_intervalMs * qMin(intervals, maxBackoffIntervals);
+}
+
+} // namespace Internal
+} // namespace Fossil
@@ -0,0 +1,92 @@
+/**************************************************************************
+**  This file is part of Fossil VCS plugin for Qt Creator
+**
+**  Copyright (c) 2013 - 2020, Artur Shepilko, <qtc-fossil@nomadbyte.com>.
+**
+**  Based on Bazaar VCS plugin for Qt Creator by Hugues Delorme.
+**
+**  Permission is hereby granted, free of charge, to any person obtaining a copy
+**  of this software and associated documentation files (the "Software"), to deal
+**  in the Software without restriction, including without limitation the rights
+**  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+**  copies of the Software, and to permit persons to whom the Software is
+**  furnished to do so, subject to the following conditions:
+**
+**  The above copyright notice and this permission notice shall be included in
+**  all copies or substantial portions of the Software.
+**
+**  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+**  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+**  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+**  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+**  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+**  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+**  THE SOFTWARE.
+**************************************************************************/
+
+
+#pragma once
+
+#include <QDateTime>
+#include <QHash>
+#include <QObject>
+#include <QStringList>
+#include <QTimer>
+
+namespace Fossil {
+namespace Internal {
+
+class FossilClient;
+
+// Pulls the repositories of the open check-outs from their default remote
+// in the background, at a fixed interval. Check-outs sharing a repository
+// file are pulled once. Failing repositories are retried with an
+// exponentially growing delay, up to a limit.
+
+class AutoPullScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Statistics {
+        QDateTime lastSync;           // of the last successful pull
+        qint64 lastLatencyMs = 0;
+        qint64 lastBytesReceived = 0;
+        int lastArtifactsReceived = 0;
+        int failureCount = 0;         // since the last success
+    };
+
+    explicit AutoPullScheduler(FossilClient *client, QObject *parent = nullptr);
+    ~AutoPullScheduler() override;
+
+    // Zero interval disables the scheduler
+    void setInterval(int minutes);
+    void setCheckouts(const QStringList &topLevels);
+
+    // Keyed by the repository file, or by the top-level if not known
+    QHash<QString, Statistics> statistics() const;
+
+signals:
+    void pulled(const QString &repository);
+
+private:
+    struct Repository {
+        QStringList topLevels;
+        Statistics statistics;
+        QDateTime nextPull;
+        bool running = false;
+    };
+
+    void schedule();
+    void pullDue();
+    void pull(const QString &key, Repository &repository);
+    qint64 retryDelayMs(int failureCount) const;
+
+    FossilClient *m_client;
+    QTimer m_timer;
+    qint64 m_intervalMs = 0;
+    QHash<QString, Repository> m_repositories;
+};
+
+} // namespace Internal
+} // namespace Fossil
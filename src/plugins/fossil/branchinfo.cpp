@@ -39,6 +39,11 @@ const QString &BranchInfo::name() const
     return m_name;
 }
 
+BranchInfo::BranchFlags BranchInfo::flags() const
+{
+    return m_flags;
+}
+
 bool BranchInfo::isCurrent() const
 {
     return m_flags.testFlag(Current);
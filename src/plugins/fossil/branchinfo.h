@@ -45,6 +45,7 @@ public:
 
 public:
     const QString &name() const;
+    BranchFlags flags() const;
     bool isCurrent() const;
     bool isClosed() const;
     bool isPrivate() const;
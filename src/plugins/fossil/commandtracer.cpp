@@ -0,0 +1,126 @@
+/**************************************************************************
+**  This file is part of Fossil VCS plugin for Qt Creator
+**
+**  Copyright (c) 2013 - 2020, Artur Shepilko, <qtc-fossil@nomadbyte.com>.
+**
+**  Based on Bazaar VCS plugin for Qt Creator by Hugues Delorme.
+**
+**  Permission is hereby granted, free of charge, to any person obtaining a copy
+**  of this software and associated documentation files (the "Software"), to deal
+**  in the Software without restriction, including without limitation the rights
+**  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+**  copies of the Software, and to permit persons to whom the Software is
+**  furnished to do so, subject to the following conditions:
+**
+**  The above copyright notice and this permission notice shall be included in
+**  all copies or substantial portions of the Software.
+**
+**  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+**  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+**  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+**  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+**  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+**  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+**  THE SOFTWARE.
+**************************************************************************/
+
+
+#include "commandtracer.h"
+
+#include <QCoreApplication>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QThread>
+
+namespace Fossil {
+namespace Internal {
+
+CommandTracer::Span::Span(CommandTracer &tracer, const QString &category, const QString &name) :
+    m_tracer(tracer)
+{
+    m_event.category = category;
+    m_event.name = name;
+    m_event.threadId = currentThreadId();
+    m_event.startUs = m_tracer.elapsedUs();
+}
+
+CommandTracer::Span::~Span()
+{
+    m_event.durationUs = m_tracer.elapsedUs() - m_event.startUs;
+    m_tracer.record(m_event);
+}
+
+void CommandTracer::Span::setArg(const QString &key, const QVariant &value)
+{
+    m_event.args.insert(key, value);
+}
+
+quint64 CommandTracer::currentThreadId()
+{
+    return quint64(quintptr(QThread::currentThreadId()));
+}
+
+CommandTracer::CommandTracer(int capacity) :
+    m_capacity(capacity)
+{
+    m_clock.start();
+}
+
+qint64 CommandTracer::elapsedUs() const
+{
+    return m_clock.nsecsElapsed() / 1000;
+}
+
+void CommandTracer::record(const Event &event)
+{
+    // Keep the most recent events
+    QMutexLocker locker(&m_mutex);
+    m_events.push_back(event);
+    while (int(m_events.size()) > m_capacity)
+        m_events.pop_front();
+}
+
+void CommandTracer::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_events.clear();
+}
+
+int CommandTracer::size() const
+{
+    QMutexLocker locker(&m_mutex);
+    return int(m_events.size());
+}
+
+QByteArray CommandTracer::toChromeTrace() const
+{
+    // Ref: "Trace Event Format", complete events ("ph": "X")
+    const qint64 processId = QCoreApplication::applicationPid();
+
+    QJsonArray traceEvents;
+    {
+        QMutexLocker locker(&m_mutex);
+        for (const Event &event : m_events) {
+            traceEvents.append(QJsonObject({
+                {"name", event.name},
+                {"cat", event.category},
+                {"ph", "X"},
+                {"ts", event.startUs},
+                {"dur", event.durationUs},
+                {"pid", processId},
+                {"tid", qint64(event.threadId)},
+                {"args", QJsonObject::fromVariantMap(event.args)}
+            }));
+        }
+    }
+
+    const QJsonObject trace({
+        {"traceEvents", traceEvents},
+        {"displayTimeUnit", "ms"}
+    });
+    return QJsonDocument(trace).toJson(QJsonDocument::Compact);
+}
+
+} // namespace Internal
+} // namespace Fossil
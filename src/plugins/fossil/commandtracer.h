@@ -0,0 +1,90 @@
+/**************************************************************************
+**  This file is part of Fossil VCS plugin for Qt Creator
+**
+**  Copyright (c) 2013 - 2020, Artur Shepilko, <qtc-fossil@nomadbyte.com>.
+**
+**  Based on Bazaar VCS plugin for Qt Creator by Hugues Delorme.
+**
+**  Permission is hereby granted, free of charge, to any person obtaining a copy
+**  of this software and associated documentation files (the "Software"), to deal
+**  in the Software without restriction, including without limitation the rights
+**  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+**  copies of the Software, and to permit persons to whom the Software is
+**  furnished to do so, subject to the following conditions:
+**
+**  The above copyright notice and this permission notice shall be included in
+**  all copies or substantial portions of the Software.
+**
+**  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+**  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+**  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+**  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+**  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+**  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+**  THE SOFTWARE.
+**************************************************************************/
+
+
+#pragma once
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QVariantMap>
+
+#include <deque>
+
+namespace Fossil {
+namespace Internal {
+
+// Records timed spans of the fossil commands run by the client,
+// exported in the Chrome trace event format (chrome://tracing).
+// Thread-safe, spans are recorded from the query pool as well.
+
+class CommandTracer
+{
+public:
+    struct Event {
+        QString category;
+        QString name;
+        qint64 startUs = 0;
+        qint64 durationUs = 0;
+        quint64 threadId = 0;
+        QVariantMap args;
+    };
+
+    // Records the time from construction to destruction as an event
+    class Span
+    {
+    public:
+        Span(CommandTracer &tracer, const QString &category, const QString &name);
+        ~Span();
+
+        void setArg(const QString &key, const QVariant &value);
+
+    private:
+        CommandTracer &m_tracer;
+        Event m_event;
+    };
+
+    explicit CommandTracer(int capacity = 100000);
+
+    static quint64 currentThreadId();
+
+    qint64 elapsedUs() const;
+    void record(const Event &event);
+    void clear();
+    int size() const;
+
+    QByteArray toChromeTrace() const;
+
+private:
+    const int m_capacity;
+    QElapsedTimer m_clock;
+    mutable QMutex m_mutex;
+    std::deque<Event> m_events; // oldest first
+};
+
+} // namespace Internal
+} // namespace Fossil
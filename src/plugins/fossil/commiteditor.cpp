@@ -26,12 +26,11 @@
 
 #include "branchinfo.h"
 #include "commiteditor.h"
-#include "constants.h"
 #include "fossilcommitwidget.h"
+#include "outputparser.h"
 
 #include <coreplugin/idocument.h>
 #include <vcsbase/submitfilemodel.h>
-#include <utils/algorithm.h>
 #include <utils/qtcassert.h>
 
 namespace Fossil {
@@ -56,32 +55,60 @@ void CommitEditor::setFields(const QString &repositoryRoot, const BranchInfo &br
     QTC_ASSERT(fossilWidget, return);
 
     fossilWidget->setFields(repositoryRoot, branch, tags, userName);
+    setFileStatus(repositoryRoot, repoStatus);
+}
+
+void CommitEditor::setFieldsPending(const QString &repositoryRoot,
+                                    const QList<VcsBase::VcsBaseClient::StatusItem> &repoStatus)
+{
+    FossilCommitWidget *fossilWidget = commitWidget();
+    QTC_ASSERT(fossilWidget, return);
+
+    fossilWidget->setFieldsPending(repositoryRoot);
+    setFileStatus(repositoryRoot, repoStatus);
+}
+
+void CommitEditor::updateFileStatus(const QList<VcsBase::VcsBaseClient::StatusItem> &repoStatus)
+{
+    QTC_ASSERT(m_fileModel, return);
 
+    VcsBase::SubmitFileModel *previousModel = m_fileModel;
+    setFileStatus(previousModel->repositoryRoot(), repoStatus);
+    m_fileModel->updateSelections(previousModel);
+    delete previousModel;
+}
+
+void CommitEditor::setFileStatus(const QString &repositoryRoot,
+                                 const QList<VcsBase::VcsBaseClient::StatusItem> &repoStatus)
+{
     m_fileModel = new VcsBase::SubmitFileModel(this);
     m_fileModel->setRepositoryRoot(repositoryRoot);
     m_fileModel->setFileStatusQualifier([](const QString &status, const QVariant &)
                                            -> VcsBase::SubmitFileModel::FileStatusHint
     {
-        if (status == Constants::FSTATUS_ADDED
-            || status == Constants::FSTATUS_ADDED_BY_MERGE
-            || status == Constants::FSTATUS_ADDED_BY_INTEGRATE) {
+        switch (OutputParser::fileStatus(status)) {
+        case FileStatus::Added:
+        case FileStatus::AddedByMerge:
+        case FileStatus::AddedByIntegrate:
             return VcsBase::SubmitFileModel::FileAdded;
-        } else if (status == Constants::FSTATUS_EDITED
-            || status == Constants::FSTATUS_UPDATED_BY_MERGE
-            || status == Constants::FSTATUS_UPDATED_BY_INTEGRATE) {
+        case FileStatus::Edited:
+        case FileStatus::UpdatedByMerge:
+        case FileStatus::UpdatedByIntegrate:
             return VcsBase::SubmitFileModel::FileModified;
-        } else if (status == Constants::FSTATUS_DELETED) {
+        case FileStatus::Deleted:
             return VcsBase::SubmitFileModel::FileDeleted;
-        } else if (status == Constants::FSTATUS_RENAMED) {
+        case FileStatus::Renamed:
             return VcsBase::SubmitFileModel::FileRenamed;
+        default:
+            return VcsBase::SubmitFileModel::FileStatusUnknown;
         }
-        return VcsBase::SubmitFileModel::FileStatusUnknown;
     } );
 
-    const QList<VcsBase::VcsBaseClient::StatusItem> toAdd = Utils::filtered(repoStatus,
-                [](const VcsBase::VcsBaseClient::StatusItem &item) { return item.flags != Constants::FSTATUS_UNKNOWN; });
-    for (const VcsBase::VcsBaseClient::StatusItem &item : toAdd)
+    // The items share the file and flag strings with the status list
+    for (const VcsBase::VcsBaseClient::StatusItem &item : repoStatus) {
+        if (OutputParser::fileStatus(item.flags) != FileStatus::Unknown)
             m_fileModel->addFile(item.file, item.flags);
+    }
 
     setFileModel(m_fileModel);
 }
@@ -47,10 +47,17 @@ public:
     void setFields(const QString &repositoryRoot, const BranchInfo &branch,
                    const QStringList &tags, const QString &userName,
                    const QList<VcsBase::VcsBaseClient::StatusItem> &repoStatus);
+    void setFieldsPending(const QString &repositoryRoot,
+                          const QList<VcsBase::VcsBaseClient::StatusItem> &repoStatus);
+    // Replaces the file list, keeping the files unchecked by the user unchecked
+    void updateFileStatus(const QList<VcsBase::VcsBaseClient::StatusItem> &repoStatus);
 
     FossilCommitWidget *commitWidget();
 
 private:
+    void setFileStatus(const QString &repositoryRoot,
+                       const QList<VcsBase::VcsBaseClient::StatusItem> &repoStatus);
+
     VcsBase::SubmitFileModel *m_fileModel = nullptr;
 };
 
@@ -32,6 +32,7 @@
 #include <utils/pathchooser.h>
 
 #include <QDir>
+#include <QPushButton>
 
 namespace Fossil {
 namespace Internal {
@@ -84,6 +85,12 @@ void ConfigureDialog::setSettings(const RepositorySettings &settings)
     d->updateUi();
 }
 
+void ConfigureDialog::setSettingsPending(bool pending)
+{
+    // Prevent applying defaults over the repository settings not retrieved yet
+    d->m_ui.buttonBox->button(QDialogButtonBox::Ok)->setEnabled(!pending);
+}
+
 void ConfigureDialog::changeEvent(QEvent *e)
 {
     QDialog::changeEvent(e);
@@ -44,6 +44,7 @@ public:
 
     const RepositorySettings settings() const;
     void setSettings(const RepositorySettings &settings);
+    void setSettingsPending(bool pending);
 
 protected:
     void changeEvent(QEvent *e) final;
@@ -93,6 +93,11 @@ const char UPDATE[] = "Fossil.Action.Update";
 const char COMMIT[] = "Fossil.Action.Commit";
 const char CONFIGURE_REPOSITORY[] = "Fossil.Action.Settings";
 const char CREATE_REPOSITORY[] = "Fossil.Action.CreateRepository";
+const char EXPORT_TRACE[] = "Fossil.Action.ExportTrace";
+const char AUTO_PULL_STATUS[] = "Fossil.Action.AutoPullStatus";
+const char STATUS_ALL_CHECKOUTS[] = "Fossil.Action.StatusAllCheckouts";
+const char PULL_ALL_CHECKOUTS[] = "Fossil.Action.PullAllCheckouts";
+const char UPDATE_ALL_CHECKOUTS[] = "Fossil.Action.UpdateAllCheckouts";
 
 // File status hint
 const char FSTATUS_ADDED[] = "Added";
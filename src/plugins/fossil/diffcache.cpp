@@ -0,0 +1,122 @@
+/**************************************************************************
+**  This file is part of Fossil VCS plugin for Qt Creator
+**
+**  Copyright (c) 2013 - 2020, Artur Shepilko, <qtc-fossil@nomadbyte.com>.
+**
+**  Based on Bazaar VCS plugin for Qt Creator by Hugues Delorme.
+**
+**  Permission is hereby granted, free of charge, to any person obtaining a copy
+**  of this software and associated documentation files (the "Software"), to deal
+**  in the Software without restriction, including without limitation the rights
+**  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+**  copies of the Software, and to permit persons to whom the Software is
+**  furnished to do so, subject to the following conditions:
+**
+**  The above copyright notice and this permission notice shall be included in
+**  all copies or substantial portions of the Software.
+**
+**  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+**  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+**  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+**  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+**  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+**  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+**  THE SOFTWARE.
+**************************************************************************/
+
+
+#include "diffcache.h"
+#include "artifactcache.h"
+
+#include <QCryptographicHash>
+
+#include <iterator>
+
+namespace Fossil {
+namespace Internal {
+
+DiffCache::DiffCache(qint64 maxMemorySize) :
+    m_maxMemorySize(maxMemorySize)
+{ }
+
+QString DiffCache::key(const QString &fromId, const QString &toId, unsigned binaryVersion,
+                       const QStringList &options)
+{
+    if (!ArtifactCache::isArtifactHash(fromId) || !ArtifactCache::isArtifactHash(toId))
+        return QString();
+
+    // The output format may change with the client version.
+    // Hashed, to be stored alongside the artifacts.
+    const QStringList parts = QStringList({"diff", fromId.toLower(), toId.toLower(),
+                                           QString::number(binaryVersion)}) + options;
+    return QString::fromLatin1(QCryptographicHash::hash(parts.join('\n').toUtf8(),
+                                                        QCryptographicHash::Sha1).toHex());
+}
+
+Utils::optional<QString> DiffCache::find(const QString &key, ArtifactCache *diskCache)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        const auto indexIt = m_index.constFind(key);
+        if (indexIt != m_index.constEnd()) {
+            const Entries::iterator it = indexIt.value();
+            m_entries.splice(m_entries.begin(), m_entries, it);
+            return it->diff;
+        }
+    }
+
+    QByteArray content;
+    if (!diskCache || !diskCache->find(key, &content))
+        return Utils::nullopt;
+
+    const QString diff = QString::fromUtf8(content);
+    QMutexLocker locker(&m_mutex);
+    insertInMemory(key, diff);
+    return diff;
+}
+
+void DiffCache::insert(const QString &key, const QString &diff, ArtifactCache *diskCache)
+{
+    if (key.isEmpty())
+        return;
+
+    {
+        QMutexLocker locker(&m_mutex);
+        insertInMemory(key, diff);
+    }
+
+    if (diskCache)
+        diskCache->insert(key, diff.toUtf8());
+}
+
+void DiffCache::insertInMemory(const QString &key, const QString &diff)
+{
+    const auto indexIt = m_index.constFind(key);
+    if (indexIt != m_index.constEnd()) {
+        m_memorySize -= entrySize(indexIt.value()->diff);
+        m_entries.erase(indexIt.value());
+        m_index.remove(key);
+    }
+
+    if (entrySize(diff) > m_maxMemorySize)
+        return;
+
+    m_entries.push_front({key, diff});
+    m_index.insert(key, m_entries.begin());
+    m_memorySize += entrySize(diff);
+
+    while (m_memorySize > m_maxMemorySize) {
+        const Entries::iterator last = std::prev(m_entries.end());
+        m_memorySize -= entrySize(last->diff);
+        m_index.remove(last->key);
+        m_entries.erase(last);
+    }
+}
+
+qint64 DiffCache::entrySize(const QString &diff)
+{
+    return qint64(diff.size()) * qint64(sizeof(QChar));
+}
+
+} // namespace Internal
+} // namespace Fossil
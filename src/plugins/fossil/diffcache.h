@@ -0,0 +1,81 @@
+/**************************************************************************
+**  This file is part of Fossil VCS plugin for Qt Creator
+**
+**  Copyright (c) 2013 - 2020, Artur Shepilko, <qtc-fossil@nomadbyte.com>.
+**
+**  Based on Bazaar VCS plugin for Qt Creator by Hugues Delorme.
+**
+**  Permission is hereby granted, free of charge, to any person obtaining a copy
+**  of this software and associated documentation files (the "Software"), to deal
+**  in the Software without restriction, including without limitation the rights
+**  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+**  copies of the Software, and to permit persons to whom the Software is
+**  furnished to do so, subject to the following conditions:
+**
+**  The above copyright notice and this permission notice shall be included in
+**  all copies or substantial portions of the Software.
+**
+**  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+**  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+**  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+**  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+**  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+**  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+**  THE SOFTWARE.
+**************************************************************************/
+
+
+
+#pragma once
+
+#include <utils/optional.h>
+
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+
+#include <list>
+
+namespace Fossil {
+namespace Internal {
+
+class ArtifactCache;
+
+// Cache of the diffs between two committed check-ins, keyed by both hashes and the
+// diff options. Such a diff never changes. The recent diffs are kept in memory up to
+// a size limit. All are spilled to the disk cache, when one is given.
+// Thread-safe, the disk is meant to be accessed from the query pool.
+
+class DiffCache
+{
+public:
+    explicit DiffCache(qint64 maxMemorySize = 16 * 1024 * 1024);
+
+    // Empty when the diff is not between two full hashes, and may not be cached
+    static QString key(const QString &fromId, const QString &toId, unsigned binaryVersion,
+                       const QStringList &options);
+
+    // Looks into the disk cache on a memory miss
+    Utils::optional<QString> find(const QString &key, ArtifactCache *diskCache = nullptr);
+    void insert(const QString &key, const QString &diff, ArtifactCache *diskCache = nullptr);
+
+private:
+    struct Entry {
+        QString key;
+        QString diff;
+    };
+    using Entries = std::list<Entry>;
+
+    void insertInMemory(const QString &key, const QString &diff);
+    static qint64 entrySize(const QString &diff);
+
+    const qint64 m_maxMemorySize;
+    QMutex m_mutex;
+    qint64 m_memorySize = 0;
+    Entries m_entries; // most recently used first
+    QHash<QString, Entries::iterator> m_index;
+};
+
+} // namespace Internal
+} // namespace Fossil
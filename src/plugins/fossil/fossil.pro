@@ -1,3 +1,5 @@
+QT += sql
+
 include(../../qtcreatorplugin.pri)
 SOURCES += \
     fossilclient.cpp \
@@ -12,6 +14,23 @@ SOURCES += \
     branchinfo.cpp \
     configuredialog.cpp \
     revisioninfo.cpp \
+    repositorydatabase.cpp \
+    revisioncache.cpp \
+    statusmodel.cpp \
+    timelinemodel.cpp \
+    timelinewidget.cpp \
+    outputparser.cpp \
+    loghighlighter.cpp \
+    commandtracer.cpp \
+    managedfileindex.cpp \
+    toplevelcache.cpp \
+    annotationcache.cpp \
+    inlineblame.cpp \
+    autopullscheduler.cpp \
+    multicheckoutrunner.cpp \
+    jobscheduler.cpp \
+    artifactcache.cpp \
+    diffcache.cpp \
     wizard/fossiljsextension.cpp
 HEADERS += \
     fossilclient.h \
@@ -27,6 +46,24 @@ HEADERS += \
     branchinfo.h \
     configuredialog.h \
     revisioninfo.h \
+    repositorydatabase.h \
+    revisioncache.h \
+    statusmodel.h \
+    timelinemodel.h \
+    timelinewidget.h \
+    outputparser.h \
+    loghighlighter.h \
+    commandtracer.h \
+    managedfileindex.h \
+    toplevelcache.h \
+    annotationcache.h \
+    inlineblame.h \
+    autopullscheduler.h \
+    multicheckoutrunner.h \
+    jobscheduler.h \
+    singleflight.h \
+    artifactcache.h \
+    diffcache.h \
     wizard/fossiljsextension.h
 FORMS += \
     optionspage.ui \
@@ -26,9 +26,12 @@
 
 #include "fossilclient.h"
 #include "fossileditor.h"
+#include "outputparser.h"
 #include "constants.h"
+#include "repositorydatabase.h"
 
 #include <coreplugin/id.h>
+#include <coreplugin/shellcommand.h>
 
 #include <vcsbase/vcsbaseplugin.h>
 #include <vcsbase/vcsbaseeditor.h>
@@ -40,17 +43,18 @@
 #include <utils/fileutils.h>
 #include <utils/hostosinfo.h>
 #include <utils/qtcassert.h>
+#include <utils/runextensions.h>
 #include <utils/utilsicons.h>
 
-#include <QSyntaxHighlighter>
-
 #include <QDateTime>
 #include <QDir>
 #include <QFile>
 #include <QFileInfo>
 #include <QTextStream>
 #include <QMap>
+#include <QMutex>
 #include <QRegularExpression>
+#include <QStandardPaths>
 
 using namespace Utils;
 
@@ -226,6 +230,32 @@ private:
     FossilClient *m_client;
 };
 
+// Sync progress, advancing with each round-trip.
+// The total is not known until the sync is done.
+class SyncProgressParser : public Core::ProgressParser
+{
+public:
+    explicit SyncProgressParser(const QSharedPointer<SyncProgress> &progress) :
+        m_progress(progress)
+    { }
+
+protected:
+    void parseProgress(const QString &text) final
+    {
+        m_pendingText += text;
+        m_pendingText.remove(0, OutputParser::parseSyncProgress(m_pendingText, m_progress.data(),
+                                                                true));
+        if (m_progress->isDone)
+            setProgressAndMaximum(1, 1);
+        else
+            setProgressAndMaximum(m_progress->roundTrips, m_progress->roundTrips + 1);
+    }
+
+private:
+    const QSharedPointer<SyncProgress> m_progress;
+    QString m_pendingText;  // the unterminated line of the last chunk
+};
+
 unsigned FossilClient::makeVersionNumber(int major, int minor, int patch)
 {
     return (QString().setNum(major).toUInt(0,16) << 16) +
@@ -246,21 +276,32 @@ QString FossilClient::makeVersionString(unsigned version)
                     .arg(versionPart(version));
 }
 
-FossilClient::FossilClient(FossilSettings *settings) : VcsBase::VcsBaseClient(settings)
+FossilClient::FossilClient(FossilSettings *settings) : VcsBase::VcsBaseClient(settings),
+    m_artifactCache(QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+                    + "/fossil/artifacts")
 {
+    // Queries are mostly short-lived reads; a few workers are enough
+    // to keep a slow or locked repository off the GUI thread.
+    m_queryPool.setMaxThreadCount(4);
+
     setDiffConfigCreator([this](QToolBar *toolBar) {
         return new FossilDiffConfig(this, toolBar);
     });
+
+    // The check-out may have been closed or opened again, the kept database
+    // connections must not keep its database file in use.
+    connect(this, &VcsBase::VcsBaseClient::changed, this, [this](const QVariant &v) {
+        if (v.type() == QVariant::String)
+            RepositoryDatabase::closeKept(findTopLevelForFile(QFileInfo(v.toString())));
+    });
 }
 
 unsigned int FossilClient::synchronousBinaryVersion() const
 {
-    if (settings().binaryPath().isEmpty())
-        return 0;
-
+    // Run by probeBinary() only, which checks for the binary path
     QStringList args("version");
 
-    const SynchronousProcessResponse response = vcsFullySynchronousExec(QString(), args);
+    const SynchronousProcessResponse response = runFossil(QString(), args);
     if (response.result != SynchronousProcessResponse::Finished)
         return 0;
 
@@ -279,50 +320,17 @@ unsigned int FossilClient::synchronousBinaryVersion() const
     return makeVersionNumber(major,minor,patch);
 }
 
-QList<BranchInfo> FossilClient::branchListFromOutput(const QString &output, const BranchInfo::BranchFlags defaultFlags)
-{
-    // Branch list format:
-    // "  branch-name"
-    // "* current-branch"
-    return Utils::transform(output.split('\n', QString::SkipEmptyParts), [=](const QString& l) {
-        const QString &name = l.mid(2);
-        QTC_ASSERT(!name.isEmpty(), return BranchInfo());
-        const BranchInfo::BranchFlags flags = (l.startsWith("* ") ? defaultFlags | BranchInfo::Current : defaultFlags);
-        return BranchInfo(name, flags);
-    });
-}
-
-BranchInfo FossilClient::synchronousCurrentBranch(const QString &workingDirectory)
+BranchInfo FossilClient::synchronousCurrentBranch(const QString &workingDirectory) const
 {
     if (workingDirectory.isEmpty())
         return BranchInfo();
 
-    // First try to get the current branch from the list of open branches
-    const SynchronousProcessResponse response = vcsFullySynchronousExec(workingDirectory, {"branch", "list"});
-    if (response.result != SynchronousProcessResponse::Finished)
-        return BranchInfo();
-
-    const QString output = sanitizeFossilOutput(response.stdOut());
-    BranchInfo currentBranch = Utils::findOrDefault(branchListFromOutput(output), [](const BranchInfo &b) {
+    return Utils::findOrDefault(synchronousBranchQuery(workingDirectory), [](const BranchInfo &b) {
         return b.isCurrent();
     });
-
-    if (!currentBranch.isCurrent()) {
-        // If not available from open branches, request it from the list of closed branches.
-        const SynchronousProcessResponse response = vcsFullySynchronousExec(workingDirectory, {"branch", "list", "--closed"});
-        if (response.result != SynchronousProcessResponse::Finished)
-            return BranchInfo();
-
-        const QString output = sanitizeFossilOutput(response.stdOut());
-        currentBranch = Utils::findOrDefault(branchListFromOutput(output, BranchInfo::Closed), [](const BranchInfo &b) {
-            return b.isCurrent();
-        });
-    }
-
-    return currentBranch;
 }
 
-QList<BranchInfo> FossilClient::synchronousBranchQuery(const QString &workingDirectory)
+QList<BranchInfo> FossilClient::synchronousBranchQuery(const QString &workingDirectory) const
 {
     // Return a list of all branches, including the closed ones.
     // Sort the list by branch name.
@@ -330,40 +338,53 @@ QList<BranchInfo> FossilClient::synchronousBranchQuery(const QString &workingDir
     if (workingDirectory.isEmpty())
         return QList<BranchInfo>();
 
-    // First get list of open branches
-    SynchronousProcessResponse response = vcsFullySynchronousExec(workingDirectory, {"branch", "list"});
-    if (response.result != SynchronousProcessResponse::Finished)
-        return QList<BranchInfo>();
+    // The current branch is asked for by the topic, the commit editor and the
+    // blame at once, share a single query among them.
+    return m_branchFlights.run(flightKey(workingDirectory, {"branch", "list"}), [&] {
+        return queryBranches(workingDirectory);
+    });
+}
 
-    QString output = sanitizeFossilOutput(response.stdOut());
-    QList<BranchInfo> branches = branchListFromOutput(output);
+QList<BranchInfo> FossilClient::queryBranches(const QString &workingDirectory) const
+{
+    if (const QSharedPointer<const RepositoryDatabase> db = repositoryDatabase(workingDirectory)) {
+        if (const Utils::optional<QList<BranchInfo>> branches = db->branches())
+            return *branches;
+    }
 
-    // Append a list of closed branches.
-    response = vcsFullySynchronousExec(workingDirectory, {"branch", "list", "--closed"});
-    if (response.result != SynchronousProcessResponse::Finished)
-        return QList<BranchInfo>();
+    QList<BranchInfo> branches;
 
-    output = sanitizeFossilOutput(response.stdOut());
-    branches.append(branchListFromOutput(output, BranchInfo::Closed));
+    if (supportedFeatures().testFlag(BranchListAllFeature)) {
+        // Get both open and closed branches in a single pass.
+        // The client marks current and private branches, but not the closed ones;
+        // closed state is only available from the repository database.
+        const SynchronousProcessResponse response =
+                runFossil(workingDirectory, {"branch", "list", "--all"});
+        if (response.result != SynchronousProcessResponse::Finished)
+            return QList<BranchInfo>();
 
-    std::sort(branches.begin(), branches.end(),
-          [](const BranchInfo &a, const BranchInfo &b) { return a.name() < b.name(); });
-    return branches;
-}
+        const QString output = fossilOutput(response);
+        CommandTracer::Span span(m_tracer, "parse", "branch list");
+        branches = OutputParser::parseBranchList(output);
 
-QStringList FossilClient::parseRevisionCommentLine(const QString &commentLine)
-{
-    // "comment:      This is a (test) commit message (user: the.name)"
+    } else {
+        // LEGACY: get list of open branches, then append a list of closed branches.
+        SynchronousProcessResponse response = runFossil(workingDirectory, {"branch", "list"});
+        if (response.result != SynchronousProcessResponse::Finished)
+            return QList<BranchInfo>();
 
-    const QRegularExpression commentRx("^comment:\\s+(.*)\\s\\(user:\\s(.*)\\)$",
-                                       QRegularExpression::CaseInsensitiveOption);
-    QTC_ASSERT(commentRx.isValid(), return QStringList());
+        branches = OutputParser::parseBranchList(fossilOutput(response));
 
-    const QRegularExpressionMatch match = commentRx.match(commentLine);
-    if (!match.hasMatch())
-        return QStringList();
+        response = runFossil(workingDirectory, {"branch", "list", "--closed"});
+        if (response.result != SynchronousProcessResponse::Finished)
+            return QList<BranchInfo>();
+
+        branches.append(OutputParser::parseBranchList(fossilOutput(response), BranchInfo::Closed));
+    }
 
-    return QStringList({match.captured(1), match.captured(2)});
+    std::sort(branches.begin(), branches.end(),
+          [](const BranchInfo &a, const BranchInfo &b) { return a.name() < b.name(); });
+    return branches;
 }
 
 RevisionInfo FossilClient::synchronousRevisionQuery(const QString &workingDirectory, const QString &id,
@@ -374,61 +395,105 @@ RevisionInfo FossilClient::synchronousRevisionQuery(const QString &workingDirect
     if (workingDirectory.isEmpty())
         return RevisionInfo();
 
+    // Details of a check-in never change, serve hash lookups from the cache.
+    // Symbolic names (tags, branches, current check-out) may move, always query those.
+    // An all-hex name looks like a hash, it is cached only as a prefix of the hash
+    // it resolves to.
+    static const QRegularExpression hashRx("^[0-9a-fA-F]{5,64}$");
+    const bool isHashId = hashRx.match(id).hasMatch();
+    const QString repository = repositoryKey(workingDirectory);
+    if (isHashId) {
+        if (const Utils::optional<RevisionInfo> revisionInfo = m_revisionCache.find(repository, id))
+            return *revisionInfo;
+        // complete the entry to be cached
+        getCommentMsg = true;
+    }
+
+    // Editors decorating the same revision ask for it at once
+    const QString key = flightKey(workingDirectory, {"info", id, getCommentMsg ? "-comment" : ""});
+    const RevisionInfo revisionInfo = m_revisionFlights.run(key, [&] {
+        return queryRevision(workingDirectory, id, getCommentMsg);
+    });
+    if (getCommentMsg && ArtifactCache::isArtifactHash(revisionInfo.id))
+        m_revisionCache.insert(repository, revisionInfo, isHashId ? id : QString());
+    return revisionInfo;
+}
+
+Utils::optional<RevisionInfo> FossilClient::cachedRevision(const QString &workingDirectory,
+                                                           const QString &id) const
+{
+    return m_revisionCache.find(repositoryKey(workingDirectory), id);
+}
+
+QString FossilClient::repositoryKey(const QString &workingDirectory) const
+{
+    // The canonical repository file, shared by its check-outs.
+    // Read once per check-out, the repository of a check-out hardly ever changes.
+    const QString topLevel = findTopLevelForFile(QFileInfo(workingDirectory));
+    if (topLevel.isEmpty())
+        return workingDirectory;
+
+    {
+        QMutexLocker locker(&m_repositoryKeysMutex);
+        const QString key = m_repositoryKeys.value(topLevel);
+        if (!key.isEmpty())
+            return key;
+    }
+
+    // Looked up outside of the lock, the concurrent lookups of a new check-out
+    // may each do it once.
+    QString repositoryFile;
+    if (const QSharedPointer<const RepositoryDatabase> db = repositoryDatabase(topLevel)) {
+        repositoryFile = db->repositoryFile();
+    } else {
+        const SynchronousProcessResponse response = runFossil(
+                    topLevel, {"info"}, ShellCommand::SuppressCommandLogging);
+        if (response.result == SynchronousProcessResponse::Finished)
+            repositoryFile = OutputParser::parseRepositoryFile(fossilOutput(response));
+    }
+
+    // Relative to the check-out when not given in full, as by 'fossil open'
+    const QString key = repositoryFile.isEmpty()
+            ? QString() : QFileInfo(QDir(topLevel), repositoryFile).canonicalFilePath();
+    if (key.isEmpty())
+        return topLevel;
+
+    QMutexLocker locker(&m_repositoryKeysMutex);
+    m_repositoryKeys.insert(topLevel, key);
+    return key;
+}
+
+RevisionInfo FossilClient::queryRevision(const QString &workingDirectory, const QString &id,
+                                         bool getCommentMsg) const
+{
+    if (const QSharedPointer<const RepositoryDatabase> db = repositoryDatabase(workingDirectory)) {
+        if (const Utils::optional<RevisionInfo> revisionInfo = db->revision(id))
+            return *revisionInfo;
+    }
+
     QStringList args("info");
     if (!id.isEmpty())
         args << id;
 
-    const SynchronousProcessResponse response = vcsFullySynchronousExec(
+    const SynchronousProcessResponse response = runFossil(
                 workingDirectory, args, ShellCommand::SuppressCommandLogging);
     if (response.result != SynchronousProcessResponse::Finished)
         return RevisionInfo();
 
-    const QString output = sanitizeFossilOutput(response.stdOut());
-
-    QString revisionId;
-    QString parentId;
-    QStringList mergeParentIds;
-    QString commentMsg;
-    QString committer;
-
-    const QRegularExpression idRx("([0-9a-f]{5,40})");
-    QTC_ASSERT(idRx.isValid(), return RevisionInfo());
-
-    const QString hashToken =
-            QString::fromUtf8(supportedFeatures().testFlag(InfoHashFeature) ? "hash: " : "uuid: ");
-
-    for (const QString &l : output.split('\n', QString::SkipEmptyParts)) {
-        if (l.startsWith("checkout: ", Qt::CaseInsensitive)
-            || l.startsWith(hashToken, Qt::CaseInsensitive)) {
-            const QRegularExpressionMatch idMatch = idRx.match(l);
-            QTC_ASSERT(idMatch.hasMatch(), return RevisionInfo());
-            revisionId = idMatch.captured(1);
-
-        } else if (l.startsWith("parent: ", Qt::CaseInsensitive)){
-            const QRegularExpressionMatch idMatch = idRx.match(l);
-            if (idMatch.hasMatch())
-                parentId = idMatch.captured(1);
-        } else if (l.startsWith("merged-from: ", Qt::CaseInsensitive)) {
-            const QRegularExpressionMatch idMatch = idRx.match(l);
-            if (idMatch.hasMatch())
-                mergeParentIds.append(idMatch.captured(1));
-        } else if (getCommentMsg && l.startsWith("comment: ", Qt::CaseInsensitive)) {
-            const QStringList commentLineParts = parseRevisionCommentLine(l);
-            commentMsg = commentLineParts.value(0);
-            committer = commentLineParts.value(1);
-        }
-    }
+    // Parsed from the raw output, the decoding is limited to the extracted fields
+    const bool infoHash = supportedFeatures().testFlag(InfoHashFeature);
+    CommandTracer::Span span(m_tracer, "parse", "info");
+    span.setArg("outputSize", response.rawStdOut.size());
+    const RevisionInfo revisionInfo = OutputParser::parseRevisionInfo(response.rawStdOut, infoHash,
+                                                                      getCommentMsg);
 
     // make sure id at least partially matches the retrieved revisionId
-    QTC_ASSERT(revisionId.startsWith(id, Qt::CaseInsensitive), return RevisionInfo());
-
-    if (parentId.isEmpty())
-        parentId = revisionId;  // root
+    QTC_ASSERT(revisionInfo.id.startsWith(id, Qt::CaseInsensitive), return RevisionInfo());
 
-    return RevisionInfo(revisionId, parentId, mergeParentIds, commentMsg, committer);
+    return revisionInfo;
 }
 
-QStringList FossilClient::synchronousTagQuery(const QString &workingDirectory, const QString &id)
+QStringList FossilClient::synchronousTagQuery(const QString &workingDirectory, const QString &id) const
 {
     // Return a list of tags for the given revision.
     // If no revision specified, all defined tags are listed.
@@ -437,21 +502,39 @@ QStringList FossilClient::synchronousTagQuery(const QString &workingDirectory, c
     if (workingDirectory.isEmpty())
         return QStringList();
 
+    return m_tagFlights.run(flightKey(workingDirectory, {"tag", "list", id}), [&] {
+        return queryTags(workingDirectory, id);
+    });
+}
+
+QStringList FossilClient::queryTags(const QString &workingDirectory, const QString &id) const
+{
+    if (const QSharedPointer<const RepositoryDatabase> db = repositoryDatabase(workingDirectory)) {
+        if (const Utils::optional<QStringList> tags = db->tags(id))
+            return *tags;
+    }
+
     QStringList args({"tag", "list"});
 
     if (!id.isEmpty())
         args << id;
 
-    const SynchronousProcessResponse response = vcsFullySynchronousExec(workingDirectory, args);
+    const SynchronousProcessResponse response = runFossil(workingDirectory, args);
     if (response.result != SynchronousProcessResponse::Finished)
         return QStringList();
 
-    const QString output = sanitizeFossilOutput(response.stdOut());
+    const QString output = fossilOutput(response);
 
     return output.split('\n', QString::SkipEmptyParts);
 }
 
-RepositorySettings FossilClient::synchronousSettingsQuery(const QString &workingDirectory)
+RepositorySettings FossilClient::synchronousSettingsQuery(const QString &workingDirectory) const
+{
+    return querySettings(workingDirectory, settings().stringValue(FossilSettings::userNameKey));
+}
+
+RepositorySettings FossilClient::querySettings(const QString &workingDirectory,
+                                               const QString &defaultUser) const
 {
     if (workingDirectory.isEmpty())
         return RepositorySettings();
@@ -460,15 +543,15 @@ RepositorySettings FossilClient::synchronousSettingsQuery(const QString &working
 
     repoSettings.user = synchronousUserDefaultQuery(workingDirectory);
     if (repoSettings.user.isEmpty())
-        repoSettings.user = settings().stringValue(FossilSettings::userNameKey);
+        repoSettings.user = defaultUser;
 
     const QStringList args("settings");
 
-    const SynchronousProcessResponse response = vcsFullySynchronousExec(workingDirectory, args);
+    const SynchronousProcessResponse response = runFossil(workingDirectory, args);
     if (response.result != SynchronousProcessResponse::Finished)
         return RepositorySettings();
 
-    const QString output = sanitizeFossilOutput(response.stdOut());
+    const QString output = fossilOutput(response);
 
     for (const QString &line : output.split('\n', QString::SkipEmptyParts)) {
         // parse settings line:
@@ -518,7 +601,7 @@ bool FossilClient::synchronousSetSetting(const QString &workingDirectory,
     if (isGlobal)
         args << "--global";
 
-    const SynchronousProcessResponse response = vcsFullySynchronousExec(workingDirectory, args);
+    const SynchronousProcessResponse response = runFossil(workingDirectory, args);
     return (response.result == SynchronousProcessResponse::Finished);
 }
 
@@ -567,18 +650,23 @@ bool FossilClient::synchronousConfigureRepository(const QString &workingDirector
     return true;
 }
 
-QString FossilClient::synchronousUserDefaultQuery(const QString &workingDirectory)
+QString FossilClient::synchronousUserDefaultQuery(const QString &workingDirectory) const
 {
     if (workingDirectory.isEmpty())
         return QString();
 
+    if (const QSharedPointer<const RepositoryDatabase> db = repositoryDatabase(workingDirectory)) {
+        if (const Utils::optional<QString> user = db->userDefault())
+            return *user;
+    }
+
     const QStringList args({"user", "default"});
 
-    const SynchronousProcessResponse response = vcsFullySynchronousExec(workingDirectory, args);
+    const SynchronousProcessResponse response = runFossil(workingDirectory, args);
     if (response.result != SynchronousProcessResponse::Finished)
         return QString();
 
-    QString output = sanitizeFossilOutput(response.stdOut());
+    QString output = fossilOutput(response);
 
     return output.trimmed();
 }
@@ -590,22 +678,22 @@ bool FossilClient::synchronousSetUserDefault(const QString &workingDirectory, co
 
     // set repository-default user
     const QStringList args({"user", "default", userName, "--user", userName});
-    const SynchronousProcessResponse response = vcsFullySynchronousExec(workingDirectory, args);
+    const SynchronousProcessResponse response = runFossil(workingDirectory, args);
     return (response.result == SynchronousProcessResponse::Finished);
 }
 
-QString FossilClient::synchronousGetRepositoryURL(const QString &workingDirectory)
+QString FossilClient::synchronousGetRepositoryURL(const QString &workingDirectory) const
 {
     if (workingDirectory.isEmpty())
         return QString();
 
     const QStringList args("remote-url");
 
-    const SynchronousProcessResponse response = vcsFullySynchronousExec(workingDirectory, args);
+    const SynchronousProcessResponse response = runFossil(workingDirectory, args);
     if (response.result != SynchronousProcessResponse::Finished)
         return QString();
 
-    QString output = sanitizeFossilOutput(response.stdOut());
+    QString output = fossilOutput(response);
     output = output.trimmed();
 
     // Fossil returns "off" when no remote-url is set.
@@ -615,7 +703,7 @@ QString FossilClient::synchronousGetRepositoryURL(const QString &workingDirector
     return output;
 }
 
-QString FossilClient::synchronousTopic(const QString &workingDirectory)
+QString FossilClient::synchronousTopic(const QString &workingDirectory) const
 {
     if (workingDirectory.isEmpty())
         return QString();
@@ -629,6 +717,245 @@ QString FossilClient::synchronousTopic(const QString &workingDirectory)
     return branchInfo.name();
 }
 
+bool FossilClient::synchronousStatusQuery(const QString &workingDirectory, const QStringList &paths,
+                                          QList<StatusItem> *items) const
+{
+    // Status lines of the changed files, optionally limited to the given
+    // paths relative to the working directory.
+    QTC_ASSERT(items, return false);
+
+    if (workingDirectory.isEmpty())
+        return false;
+
+    QStringList args("changes");
+    args << paths;
+
+    const SynchronousProcessResponse response = runFossil(workingDirectory, args);
+    if (response.result != SynchronousProcessResponse::Finished)
+        return false;
+
+    // Parsed from the raw output, only the paths are decoded, the flags are shared
+    CommandTracer::Span span(m_tracer, "parse", "changes");
+    span.setArg("outputSize", response.rawStdOut.size());
+    const StatusRecords records = OutputParser::parseStatus(response.rawStdOut);
+    const char *const data = response.rawStdOut.constData();
+    items->clear();
+    items->reserve(records.size());
+    for (const StatusRecord &record : records) {
+        StatusItem item;
+        item.flags = OutputParser::statusFlags(record.status);
+        item.file = QString::fromUtf8(data + record.pathOffset, record.pathSize);
+        items->append(item);
+    }
+    return true;
+}
+
+bool FossilClient::synchronousManagedFilesQuery(const QString &topLevel, QStringList *files) const
+{
+    // Paths of the files in the current check-out, relative to the top-level.
+    QTC_ASSERT(files, return false);
+
+    if (topLevel.isEmpty())
+        return false;
+
+    if (const QSharedPointer<const RepositoryDatabase> db = repositoryDatabase(topLevel)) {
+        if (const Utils::optional<QStringList> managedFiles = db->managedFiles()) {
+            *files = *managedFiles;
+            return true;
+        }
+    }
+
+    const SynchronousProcessResponse response = runFossil(topLevel, {"ls"});
+    if (response.result != SynchronousProcessResponse::Finished)
+        return false;
+
+    const QString output = fossilOutput(response);
+
+    CommandTracer::Span span(m_tracer, "parse", "ls");
+    *files = output.split('\n', QString::SkipEmptyParts);
+    return true;
+}
+
+QSharedPointer<const BlameLines> FossilClient::synchronousBlameQuery(const QString &file) const
+{
+    // Blame the version of the file in the current check-out,
+    // the result is cached by the check-out revision.
+
+    const QFileInfo fileInfo(file);
+    const QString topLevel = findTopLevelForFile(fileInfo);
+    if (topLevel.isEmpty())
+        return {};
+
+    const QString revision = synchronousRevisionQuery(topLevel).id;
+    if (revision.isEmpty())
+        return {};
+
+    const QString relativePath = QDir(topLevel).relativeFilePath(fileInfo.absoluteFilePath());
+    if (const QSharedPointer<const BlameLines> lines = m_annotationCache.find(relativePath, revision))
+        return lines;
+
+    const SynchronousProcessResponse response = runFossil(topLevel, {"blame", relativePath});
+    if (response.result != SynchronousProcessResponse::Finished)
+        return {};
+
+    const QString output = fossilOutput(response);
+
+    CommandTracer::Span span(m_tracer, "parse", "blame");
+    return m_annotationCache.insert(relativePath, revision, OutputParser::parseBlame(output));
+}
+
+bool FossilClient::synchronousFileRevisionQuery(const QString &file, const QString &revision,
+                                                QByteArray *content) const
+{
+    // The file is looked up in the check-in manifest, then fetched by its hash.
+    // Both are artifacts kept in the artifact cache, so revisiting a version
+    // of the file runs no fossil command.
+
+    QTC_ASSERT(content, return false);
+
+    const QFileInfo fileInfo(file);
+    const QString topLevel = findTopLevelForFile(fileInfo);
+    if (topLevel.isEmpty() || revision.isEmpty())
+        return false;
+
+    const QString checkinId = synchronousRevisionQuery(topLevel, revision).id;
+    if (checkinId.isEmpty())
+        return false;
+
+    const QString relativePath = QDir(topLevel).relativeFilePath(fileInfo.absoluteFilePath());
+    QByteArray manifest;
+    if (!queryArtifact(topLevel, checkinId, &manifest))
+        return false;
+
+    QString baselineId;
+    Utils::optional<QString> fileId =
+            OutputParser::parseManifestFileHash(manifest, relativePath, &baselineId);
+    if (!fileId && !baselineId.isEmpty()) {
+        // A delta manifest lists only the files changed since its baseline
+        if (!queryArtifact(topLevel, baselineId, &manifest))
+            return false;
+        fileId = OutputParser::parseManifestFileHash(manifest, relativePath);
+    }
+    if (!fileId || fileId->isEmpty())
+        return false;
+
+    return queryArtifact(topLevel, *fileId, content);
+}
+
+bool FossilClient::queryArtifact(const QString &workingDirectory, const QString &id,
+                                 QByteArray *content) const
+{
+    if (artifactCache().find(id, content))
+        return true;
+
+    const SynchronousProcessResponse response = runFossil(workingDirectory, {"artifact", id});
+    if (response.result != SynchronousProcessResponse::Finished)
+        return false;
+
+    *content = response.rawStdOut;
+    m_artifactCache.insert(id, *content);
+    return true;
+}
+
+QFuture<BranchInfo> FossilClient::currentBranchQuery(const QString &workingDirectory) const
+{
+    return Utils::runAsync(&m_queryPool, [this, workingDirectory] {
+        return synchronousCurrentBranch(workingDirectory);
+    });
+}
+
+QFuture<QList<BranchInfo>> FossilClient::branchQuery(const QString &workingDirectory) const
+{
+    return Utils::runAsync(&m_queryPool, [this, workingDirectory] {
+        return synchronousBranchQuery(workingDirectory);
+    });
+}
+
+QFuture<RevisionInfo> FossilClient::revisionQuery(const QString &workingDirectory, const QString &id,
+                                                  bool getCommentMsg) const
+{
+    return Utils::runAsync(&m_queryPool, [this, workingDirectory, id, getCommentMsg] {
+        return synchronousRevisionQuery(workingDirectory, id, getCommentMsg);
+    });
+}
+
+QFuture<QStringList> FossilClient::tagQuery(const QString &workingDirectory, const QString &id) const
+{
+    return Utils::runAsync(&m_queryPool, [this, workingDirectory, id] {
+        return synchronousTagQuery(workingDirectory, id);
+    });
+}
+
+QFuture<RepositorySettings> FossilClient::settingsQuery(const QString &workingDirectory) const
+{
+    // The settings are not to be read on the query pool
+    const QString defaultUser = settings().stringValue(FossilSettings::userNameKey);
+    return Utils::runAsync(&m_queryPool, [this, workingDirectory, defaultUser] {
+        return querySettings(workingDirectory, defaultUser);
+    });
+}
+
+QFuture<QString> FossilClient::userDefaultQuery(const QString &workingDirectory) const
+{
+    return Utils::runAsync(&m_queryPool, [this, workingDirectory] {
+        return synchronousUserDefaultQuery(workingDirectory);
+    });
+}
+
+QFuture<QString> FossilClient::repositoryUrlQuery(const QString &workingDirectory) const
+{
+    return Utils::runAsync(&m_queryPool, [this, workingDirectory] {
+        return synchronousGetRepositoryURL(workingDirectory);
+    });
+}
+
+QFuture<QString> FossilClient::topicQuery(const QString &workingDirectory) const
+{
+    return Utils::runAsync(&m_queryPool, [this, workingDirectory] {
+        return synchronousTopic(workingDirectory);
+    });
+}
+
+QFuture<QList<FossilClient::StatusItem>> FossilClient::statusQuery(const QString &workingDirectory,
+                                                                  const QStringList &paths) const
+{
+    return Utils::runAsync(&m_queryPool, [this, workingDirectory, paths](QFutureInterface<QList<StatusItem>> &fi) {
+        QList<StatusItem> items;
+        if (synchronousStatusQuery(workingDirectory, paths, &items))
+            fi.reportResult(items);
+    });
+}
+
+QFuture<QSharedPointer<const BlameLines>> FossilClient::blameQuery(const QString &file) const
+{
+    return Utils::runAsync(&m_queryPool, [this, file] {
+        return synchronousBlameQuery(file);
+    });
+}
+
+QFuture<QByteArray> FossilClient::fileRevisionQuery(const QString &file, const QString &revision) const
+{
+    return Utils::runAsync(&m_queryPool, [this, file, revision](QFutureInterface<QByteArray> &fi) {
+        QByteArray content;
+        if (synchronousFileRevisionQuery(file, revision, &content))
+            fi.reportResult(content);
+    });
+}
+
+void FossilClient::applySettings()
+{
+    const bool useDatabaseBackend = settings().boolValue(FossilSettings::useDatabaseBackendKey);
+    if (m_useDatabaseBackend.fetchAndStoreOrdered(useDatabaseBackend) && !useDatabaseBackend)
+        RepositoryDatabase::closeKept();
+    const int cacheSizeMb = settings().intValue(FossilSettings::artifactCacheSizeKey);
+    m_artifactCache.setMaxSize(qint64(cacheSizeMb) * 1024 * 1024);
+
+    QMutexLocker locker(&m_binaryInfoMutex);
+    m_binaryPath = settings().binaryPath().toString();
+    m_storedBinaryFingerprint = settings().stringValue(FossilSettings::binaryFingerprintKey);
+    m_storedBinaryVersion = unsigned(settings().intValue(FossilSettings::binaryVersionKey));
+}
+
 bool FossilClient::synchronousCreateRepository(const QString &workingDirectory, const QStringList &extraOptions)
 {
     VcsBase::VcsOutputWindow *outputWindow = VcsBase::VcsOutputWindow::instance();
@@ -654,11 +981,11 @@ bool FossilClient::synchronousCreateRepository(const QString &workingDirectory,
     if (!adminUser.isEmpty())
         args << "--admin-user" << adminUser;
     args << extraOptions << repoFilePath.toUserOutput();
-    SynchronousProcessResponse response = vcsFullySynchronousExec(workingDirectory, args);
+    SynchronousProcessResponse response = runFossil(workingDirectory, args);
     if (response.result != SynchronousProcessResponse::Finished)
         return false;
 
-    QString output = sanitizeFossilOutput(response.stdOut());
+    QString output = fossilOutput(response);
     outputWindow->append(output);
 
     // check out the created repository file into the working directory
@@ -668,11 +995,12 @@ bool FossilClient::synchronousCreateRepository(const QString &workingDirectory,
     output.clear();
 
     args << "open" << repoFilePath.toUserOutput();
-    response = vcsFullySynchronousExec(workingDirectory, args);
+    response = runFossil(workingDirectory, args);
+    m_topLevelCache.invalidate(workingDirectory);
     if (response.result != SynchronousProcessResponse::Finished)
         return false;
 
-    output = sanitizeFossilOutput(response.stdOut());
+    output = fossilOutput(response);
     outputWindow->append(output);
 
     // set user default to admin if specified
@@ -683,11 +1011,11 @@ bool FossilClient::synchronousCreateRepository(const QString &workingDirectory,
         output.clear();
 
         args << "user" << "default" << adminUser << "--user" << adminUser;
-        response = vcsFullySynchronousExec(workingDirectory, args);
+        response = runFossil(workingDirectory, args);
         if (response.result != SynchronousProcessResponse::Finished)
             return false;
 
-        QString output = sanitizeFossilOutput(response.stdOut());
+        QString output = fossilOutput(response);
         outputWindow->append(output);
     }
 
@@ -709,7 +1037,7 @@ bool FossilClient::synchronousMove(const QString &workingDir,
 
     QStringList args(vcsCommandString(MoveCommand));
     args << extraOptions << from << to;
-    const SynchronousProcessResponse response = vcsFullySynchronousExec(workingDir, args);
+    const SynchronousProcessResponse response = runFossil(workingDir, args);
     return (response.result == SynchronousProcessResponse::Finished);
 }
 
@@ -758,6 +1086,55 @@ bool FossilClient::synchronousPush(const QString &workingDir, const QString &dst
     return (resp.result == SynchronousProcessResponse::Finished);
 }
 
+void FossilClient::pull(const QString &workingDir, const QString &srcLocation,
+                        const QStringList &extraOptions)
+{
+    QStringList args(vcsCommandString(PullCommand));
+    if (!srcLocation.isEmpty())
+        args << srcLocation;
+    args << extraOptions;
+    enqueueSync(workingDir, args);
+}
+
+void FossilClient::push(const QString &workingDir, const QString &dstLocation,
+                        const QStringList &extraOptions)
+{
+    QStringList args(vcsCommandString(PushCommand));
+    if (!dstLocation.isEmpty())
+        args << dstLocation;
+    args << extraOptions;
+    enqueueSync(workingDir, args);
+}
+
+void FossilClient::enqueueSync(const QString &workingDir, const QStringList &args)
+{
+    // Runs in the background with the progress shown in the progress bar,
+    // which also allows to cancel the command.
+    const auto progress = QSharedPointer<SyncProgress>::create();
+
+    VcsBase::VcsCommand *cmd = createCommand(workingDir);
+    // Disable UNIX terminals to suppress SSH prompting
+    cmd->addFlags(VcsBase::VcsCommand::SshPasswordPrompt
+                  | VcsBase::VcsCommand::ShowStdOut
+                  | VcsBase::VcsCommand::ShowSuccessMessage);
+    cmd->setProgressParser(new SyncProgressParser(progress));
+
+    // Indicate repository change
+    cmd->setCookie(workingDir);
+    connect(cmd, &VcsBase::VcsCommand::success, this, &VcsBase::VcsBaseClient::changed, Qt::QueuedConnection);
+    connect(cmd, &VcsBase::VcsCommand::finished, this, [progress](bool ok) {
+        if (!ok || !progress->isDone)
+            return;
+        VcsBase::VcsOutputWindow::appendMessage(
+                    tr("%n round-trip(s), artifacts sent: %1, received: %2, bytes sent: %3, received: %4.",
+                       nullptr, progress->roundTrips)
+                    .arg(progress->artifactsSent).arg(progress->artifactsReceived)
+                    .arg(progress->bytesSent).arg(progress->bytesReceived));
+    });
+
+    enqueueFossilJob(cmd, args, JobScheduler::Bulk);
+}
+
 void FossilClient::commit(const QString &repositoryRoot, const QStringList &files,
                           const QString &commitMessageFile, const QStringList &extraOptions)
 {
@@ -802,7 +1179,15 @@ VcsBase::VcsBaseEditorWidget *FossilClient::annotate(
     if (VcsBase::VcsBaseEditorConfig *editorConfig = fossilEditor->editorConfig())
         effectiveArgs = editorConfig->arguments();
 
-    VcsBase::VcsCommand *cmd = createCommand(workingDir, fossilEditor);
+    // Stream the output into the editor, rather than setting it once complete.
+    // The editor still tracks the command for the progress and failure report.
+    VcsBase::VcsCommand *cmd = createCommand(workingDir);
+    fossilEditor->setCommand(cmd);
+    cmd->setProgressiveOutput(true);
+    connect(cmd, &VcsBase::VcsCommand::stdOutText,
+            fossilEditor, &FossilEditorWidget::appendStreamedOutput);
+    connect(cmd, &VcsBase::VcsCommand::finished,
+            fossilEditor, &FossilEditorWidget::finishStreamedOutput);
 
     // here we introduce a "|BLAME|" meta-option to allow both annotate and blame modes
     int pos = effectiveArgs.indexOf("|BLAME|");
@@ -820,9 +1205,10 @@ VcsBase::VcsBaseEditorWidget *FossilClient::annotate(
     // When version list requested, ignore the source line.
     if (args.contains("--log"))
         lineNumber = -1;
-    cmd->setCookie(lineNumber);
+    // The editor goes to the line as soon as it arrives
+    fossilEditor->beginStreamedOutput(lineNumber);
 
-    enqueueJob(cmd, args);
+    enqueueFossilJob(cmd, args, JobScheduler::Interactive, fossilEditor);
     return fossilEditor;
 }
 
@@ -836,44 +1222,107 @@ bool FossilClient::isVcsFileOrDirectory(const FilePath &filePath) const
 
 QString FossilClient::findTopLevelForFile(const QFileInfo &file) const
 {
-    const QString repositoryCheckFile = Constants::FOSSILREPO;
     return file.isDir() ?
-                VcsBase::findRepositoryForDirectory(file.absoluteFilePath(), repositoryCheckFile) :
-                VcsBase::findRepositoryForDirectory(file.absolutePath(), repositoryCheckFile);
+                m_topLevelCache.find(file.absoluteFilePath()) :
+                m_topLevelCache.find(file.absolutePath());
 }
 
 bool FossilClient::managesFile(const QString &workingDirectory, const QString &fileName) const
 {
-    const QStringList args({"finfo", fileName});
-    const SynchronousProcessResponse response = vcsFullySynchronousExec(workingDirectory, args);
-    if (response.result != SynchronousProcessResponse::Finished)
+    const QString filePath = QDir(workingDirectory).absoluteFilePath(fileName);
+    const QString topLevel = findTopLevelForFile(QFileInfo(filePath));
+    if (topLevel.isEmpty())
         return false;
-    QString output = sanitizeFossilOutput(response.stdOut());
-    return !output.startsWith("no history for file", Qt::CaseInsensitive);
+
+    const QString relativePath = QDir(topLevel).relativeFilePath(filePath);
+    if (const Utils::optional<bool> managed = m_managedFileIndex.contains(topLevel, relativePath))
+        return *managed;
+
+    // Take the time stamp first, so that a concurrent change drops the new index
+    const QDateTime databaseModified = ManagedFileIndex::databaseModified(topLevel);
+    QStringList files;
+    if (!synchronousManagedFilesQuery(topLevel, &files))
+        return false;
+
+    m_managedFileIndex.insert(topLevel, files, databaseModified);
+    return files.contains(relativePath, HostOsInfo::fileNameCaseSensitivity());
+}
+
+ManagedFileIndex &FossilClient::managedFileIndex() const
+{
+    return m_managedFileIndex;
+}
+
+TopLevelCache &FossilClient::topLevelCache() const
+{
+    return m_topLevelCache;
 }
 
 unsigned int FossilClient::binaryVersion() const
 {
-    static unsigned int cachedBinaryVersion = 0;
-    static QString cachedBinaryPath;
+    return probeBinary().version;
+}
+
+FossilClient::BinaryInfo FossilClient::probeBinary() const
+{
+    // Queries may run on the query pool too, they read the copies of the settings
+    // taken by applySettings() only.
+    QMutexLocker locker(&m_binaryInfoMutex);
 
-    const QString currentBinaryPath = settings().binaryPath().toString();
+    const QString currentBinaryPath = m_binaryPath;
 
     if (currentBinaryPath.isEmpty())
-        return 0;
+        return BinaryInfo();
+
+    if (m_binaryInfo.version && currentBinaryPath == m_binaryInfoPath)
+        return m_binaryInfo;
+
+    // Reuse the version probed in an earlier session,
+    // unless the binary has been replaced since.
+    const QString fingerprint = binaryFingerprint(currentBinaryPath);
+    unsigned int version = 0;
+    if (!fingerprint.isEmpty()
+            && fingerprint == m_storedBinaryFingerprint) {
+        version = m_storedBinaryVersion;
+    }
+
+    if (!version) {
+        version = synchronousBinaryVersion();
+        if (version && !fingerprint.isEmpty())
+            storeBinaryVersion(fingerprint, version);
+    }
 
     // Invalidate cache on failed version result.
     // Assume that fossil client options have been changed and will change again.
-    if (!cachedBinaryVersion
-        || currentBinaryPath != cachedBinaryPath) {
-        cachedBinaryVersion = synchronousBinaryVersion();
-        if (cachedBinaryVersion)
-            cachedBinaryPath = currentBinaryPath;
-        else
-            cachedBinaryPath.clear();
-    }
+    m_binaryInfo.version = version;
+    m_binaryInfo.features = featuresForVersion(version);
+    m_binaryInfoPath = version ? currentBinaryPath : QString();
 
-    return cachedBinaryVersion;
+    return m_binaryInfo;
+}
+
+QString FossilClient::binaryFingerprint(const QString &binaryPath)
+{
+    const QFileInfo binaryInfo(binaryPath);
+    if (!binaryInfo.isFile())
+        return QString();
+
+    return QString("%1|%2|%3").arg(binaryInfo.canonicalFilePath())
+            .arg(binaryInfo.size())
+            .arg(binaryInfo.lastModified().toMSecsSinceEpoch());
+}
+
+void FossilClient::storeBinaryVersion(const QString &fingerprint, unsigned int version) const
+{
+    // Called with the binary info locked
+    m_storedBinaryFingerprint = fingerprint;
+    m_storedBinaryVersion = version;
+
+    // Settings are owned by the GUI thread, they are saved with the rest of the session
+    QMetaObject::invokeMethod(const_cast<FossilClient *>(this), [this, fingerprint, version] {
+        settings().setValue(FossilSettings::binaryFingerprintKey, fingerprint);
+        settings().setValue(FossilSettings::binaryVersionKey, int(version));
+    }, Qt::QueuedConnection);
 }
 
 QString FossilClient::binaryVersionString() const
@@ -887,18 +1336,23 @@ QString FossilClient::binaryVersionString() const
 }
 
 FossilClient::SupportedFeatures FossilClient::supportedFeatures() const
+{
+    return probeBinary().features;
+}
+
+FossilClient::SupportedFeatures FossilClient::featuresForVersion(unsigned int version)
 {
     // use for legacy client support to test for feature presence
     // e.g. supportedFeatures().testFlag(TimelineWidthFeature)
 
     SupportedFeatures features = AllSupportedFeatures; // all inclusive by default (~0U)
 
-    const unsigned int version = binaryVersion();
-
     if (version < 0x21200) {
         features &= ~InfoHashFeature;
         if (version < 0x20400)
             features &= ~AnnotateRevisionFeature;
+        if (version < 0x20000)
+            features &= ~ChangesPathsFeature;
         if (version < 0x13000)
             features &= ~TimelinePathFeature;
         if (version < 0x12900)
@@ -907,6 +1361,8 @@ FossilClient::SupportedFeatures FossilClient::supportedFeatures() const
             features &= ~AnnotateBlameFeature;
             features &= ~TimelineWidthFeature;
         }
+        if (version < 0x12000)
+            features &= ~BranchListAllFeature;
     }
 
     return features;
@@ -933,52 +1389,51 @@ void FossilClient::view(const QString &source, const QString &id, const QStringL
                                                            VcsBase::VcsBaseEditor::getCodec(source), "view", id);
     editor->setWorkingDirectory(workingDirectory);
 
-    enqueueJob(createCommand(workingDirectory, editor), args);
-}
-
-class FossilLogHighlighter : QSyntaxHighlighter
-{
-public:
-    explicit FossilLogHighlighter(QTextDocument *parent);
-    virtual void highlightBlock(const QString &text) final;
-
-private:
-    const QRegularExpression m_revisionIdRx;
-    const QRegularExpression m_dateRx;
-};
+    // The diff between two check-ins never changes, show it from the cache when there
+    const QString diffKey = DiffCache::key(revisionInfo.parentId, revisionInfo.id,
+                                           binaryVersion(), extraOptions);
+    if (diffKey.isEmpty()) {
+        enqueueViewDiff(editor, workingDirectory, args, diffKey);
+        return;
+    }
+    if (const Utils::optional<QString> diff = m_diffCache.find(diffKey)) {
+        editor->setPlainText(*diff);
+        return;
+    }
 
-FossilLogHighlighter::FossilLogHighlighter(QTextDocument * parent) :
-    QSyntaxHighlighter(parent),
-    m_revisionIdRx(Constants::CHANGESET_ID),
-    m_dateRx("([0-9]{4}-[0-9]{2}-[0-9]{2})")
-{
-    QTC_CHECK(m_revisionIdRx.isValid());
-    QTC_CHECK(m_dateRx.isValid());
+    // The disk is not read on the GUI thread
+    const QFuture<QString> future = Utils::runAsync(&m_queryPool, [this, diffKey](QFutureInterface<QString> &fi) {
+        if (const Utils::optional<QString> diff = m_diffCache.find(diffKey, &artifactCache()))
+            fi.reportResult(*diff);
+    });
+    Utils::onFinished(future, editor, [this, editor, workingDirectory, args, diffKey](const QFuture<QString> &future) {
+        if (future.resultCount() > 0)
+            editor->setPlainText(future.result());
+        else
+            enqueueViewDiff(editor, workingDirectory, args, diffKey);
+    });
 }
 
-void FossilLogHighlighter::highlightBlock(const QString &text)
+void FossilClient::enqueueViewDiff(VcsBase::VcsBaseEditorWidget *editor,
+                                   const QString &workingDirectory, const QStringList &args,
+                                   const QString &diffKey) const
 {
-    // Match the revision-ids and dates -- highlight them for convenience.
-
-    // Format revision-ids
-    QRegularExpressionMatchIterator i = m_revisionIdRx.globalMatch(text);
-    while (i.hasNext()) {
-        const QRegularExpressionMatch revisionIdMatch = i.next();
-        QTextCharFormat charFormat = format(0);
-        charFormat.setForeground(Qt::darkBlue);
-        //charFormat.setFontItalic(true);
-        setFormat(revisionIdMatch.capturedStart(0), revisionIdMatch.capturedLength(0), charFormat);
-    }
-
-    // Format dates
-    i = m_dateRx.globalMatch(text);
-    while (i.hasNext()) {
-        const QRegularExpressionMatch dateMatch = i.next();
-        QTextCharFormat charFormat = format(0);
-        charFormat.setForeground(Qt::darkBlue);
-        charFormat.setFontWeight(QFont::DemiBold);
-        setFormat(dateMatch.capturedStart(0), dateMatch.capturedLength(0), charFormat);
+    VcsBase::VcsCommand *cmd = createCommand(workingDirectory, editor);
+    if (!diffKey.isEmpty()) {
+        const QSharedPointer<QString> output(new QString);
+        connect(cmd, &VcsBase::VcsCommand::stdOutText, this, [output](const QString &text) {
+            output->append(text);
+        });
+        connect(cmd, &VcsBase::VcsCommand::finished, this, [this, output, diffKey](bool ok) {
+            if (!ok)
+                return;
+            const QString diff = *output;
+            Utils::runAsync(&m_queryPool, [this, diffKey, diff] {
+                m_diffCache.insert(diffKey, diff, &artifactCache());
+            });
+        });
     }
+    enqueueFossilJob(cmd, args, JobScheduler::Interactive, editor);
 }
 
 void FossilClient::log(const QString &workingDir, const QStringList &files,
@@ -1023,15 +1478,16 @@ void FossilClient::log(const QString &workingDir, const QStringList &files,
     if (VcsBase::VcsBaseEditorConfig *editorConfig = fossilEditor->editorConfig())
         effectiveArgs = editorConfig->arguments();
 
-    //@TODO: move highlighter and widgets to fossil editor sources.
+    //@TODO: move widgets to fossil editor sources.
 
-    new FossilLogHighlighter(fossilEditor->document());
+    fossilEditor->enableLogHighlighting();
 
     QStringList args(vcsCmdString);
     args << effectiveArgs;
     if (!files.isEmpty())
          args << "--path" << files;
-    enqueueJob(createCommand(workingDir, fossilEditor), args);
+    enqueueFossilJob(createCommand(workingDir, fossilEditor), args, JobScheduler::Interactive,
+                     fossilEditor);
 }
 
 void FossilClient::logCurrentFile(const QString &workingDir, const QStringList &files,
@@ -1075,13 +1531,14 @@ void FossilClient::logCurrentFile(const QString &workingDir, const QStringList &
     if (VcsBase::VcsBaseEditorConfig *editorConfig = fossilEditor->editorConfig())
         effectiveArgs = editorConfig->arguments();
 
-    //@TODO: move highlighter and widgets to fossil editor sources.
+    //@TODO: move widgets to fossil editor sources.
 
-    new FossilLogHighlighter(fossilEditor->document());
+    fossilEditor->enableLogHighlighting();
 
     QStringList args(vcsCmdString);
     args << effectiveArgs << files;
-    enqueueJob(createCommand(workingDir, fossilEditor), args);
+    enqueueFossilJob(createCommand(workingDir, fossilEditor), args, JobScheduler::Interactive,
+                     fossilEditor);
 }
 
 void FossilClient::revertFile(const QString &workingDir,
@@ -1099,7 +1556,7 @@ void FossilClient::revertFile(const QString &workingDir,
     VcsBase::VcsCommand *cmd = createCommand(workingDir);
     cmd->setCookie(QStringList(workingDir + "/" + file));
     connect(cmd, &VcsBase::VcsCommand::success, this, &VcsBase::VcsBaseClient::changed, Qt::QueuedConnection);
-    enqueueJob(cmd, args);
+    enqueueFossilJob(cmd, args);
 }
 
 void FossilClient::revertAll(const QString &workingDir, const QString &revision, const QStringList &extraOptions)
@@ -1125,7 +1582,102 @@ void FossilClient::revertAll(const QString &workingDir, const QString &revision,
     VcsBase::VcsCommand *cmd = createCommand(workingDir);
     cmd->setCookie(QStringList(workingDir));
     connect(cmd, &VcsBase::VcsCommand::success, this, &VcsBase::VcsBaseClient::changed, Qt::QueuedConnection);
-    enqueueJob(createCommand(workingDir), args);
+    enqueueFossilJob(cmd, args);
+}
+
+QString FossilClient::flightKey(const QString &workingDirectory, const QStringList &args) const
+{
+    // Working directories of the same check-out yield the same output
+    QString topLevel = findTopLevelForFile(QFileInfo(workingDirectory));
+    if (topLevel.isEmpty())
+        topLevel = workingDirectory;
+    return topLevel + QLatin1Char('\0') + args.join(QLatin1Char('\0'));
+}
+
+QSharedPointer<const RepositoryDatabase> FossilClient::repositoryDatabase(
+        const QString &workingDirectory) const
+{
+    if (!m_useDatabaseBackend.loadAcquire()) {
+        // Closes the connections of this thread kept from before the backend was disabled
+        RepositoryDatabase::releaseClosed();
+        return {};
+    }
+    return RepositoryDatabase::forCheckout(findTopLevelForFile(QFileInfo(workingDirectory)));
+}
+
+ArtifactCache &FossilClient::artifactCache() const
+{
+    return m_artifactCache;
+}
+
+SynchronousProcessResponse FossilClient::runFossil(const QString &workingDirectory,
+                                                   const QStringList &args, unsigned flags) const
+{
+    CommandTracer::Span span(m_tracer, "exec", args.value(0));
+    span.setArg("command", args.join(' '));
+    span.setArg("workingDirectory", workingDirectory);
+
+    const SynchronousProcessResponse response = vcsFullySynchronousExec(workingDirectory, args, flags);
+
+    span.setArg("result", int(response.result));
+    span.setArg("exitCode", response.exitCode);
+    span.setArg("outputSize", response.rawStdOut.size());
+    return response;
+}
+
+QString FossilClient::fossilOutput(const SynchronousProcessResponse &response) const
+{
+    QString output;
+    {
+        CommandTracer::Span span(m_tracer, "decode", "stdout");
+        span.setArg("outputSize", response.rawStdOut.size());
+        output = response.stdOut();
+    }
+
+    CommandTracer::Span span(m_tracer, "sanitize", "stdout");
+    return sanitizeFossilOutput(output);
+}
+
+void FossilClient::enqueueFossilJob(VcsBase::VcsCommand *cmd, const QStringList &args,
+                                    JobScheduler::Priority priority, const QObject *owner) const
+{
+    // The span covers the time the job waits in the queue, its run,
+    // and the handling of its output by the bound editor.
+    CommandTracer::Event event;
+    event.category = "job";
+    event.name = args.value(0);
+    event.startUs = m_tracer.elapsedUs();
+    event.threadId = CommandTracer::currentThreadId();
+    event.args.insert("command", args.join(' '));
+    event.args.insert("workingDirectory", cmd->defaultWorkingDirectory());
+
+    connect(cmd, &VcsBase::VcsCommand::finished,
+            this, [this, event](bool ok, int exitCode) mutable {
+        event.durationUs = m_tracer.elapsedUs() - event.startUs;
+        event.args.insert("ok", ok);
+        event.args.insert("exitCode", exitCode);
+        m_tracer.record(event);
+    });
+
+    const QString workingDirectory = cmd->defaultWorkingDirectory();
+    QString checkout = findTopLevelForFile(QFileInfo(workingDirectory));
+    if (checkout.isEmpty())
+        checkout = workingDirectory;
+
+    m_jobScheduler.setMaxJobsPerCheckout(settings().intValue(FossilSettings::maxJobsPerCheckoutKey));
+    m_jobScheduler.schedule(cmd, priority, checkout, owner, [this, args](VcsBase::VcsCommand *cmd) {
+        enqueueJob(cmd, args);
+    });
+}
+
+void FossilClient::cancelJobs(const QObject *owner) const
+{
+    m_jobScheduler.cancel(owner);
+}
+
+CommandTracer &FossilClient::tracer() const
+{
+    return m_tracer;
 }
 
 QString FossilClient::sanitizeFossilOutput(const QString &output) const
@@ -1189,61 +1741,7 @@ QStringList FossilClient::revisionSpec(const QString &revision) const
 
 FossilClient::StatusItem FossilClient::parseStatusLine(const QString &line) const
 {
-    StatusItem item;
-
-    // Ref: fossil source 'src/checkin.c' status_report()
-    // Expect at least one non-leading blank space.
-
-    int pos = line.indexOf(' ');
-
-    if (line.isEmpty() || pos < 1)
-        return StatusItem();
-
-    QString label(line.left(pos));
-    QString flags;
-
-    if (label == "EDITED")
-        flags = Constants::FSTATUS_EDITED;
-    else if (label == "ADDED")
-        flags = Constants::FSTATUS_ADDED;
-    else if (label == "RENAMED")
-        flags = Constants::FSTATUS_RENAMED;
-    else if (label == "DELETED")
-        flags = Constants::FSTATUS_DELETED;
-    else if (label == "MISSING")
-        flags = "Missing";
-    else if (label == "ADDED_BY_MERGE")
-        flags = Constants::FSTATUS_ADDED_BY_MERGE;
-    else if (label == "UPDATED_BY_MERGE")
-        flags = Constants::FSTATUS_UPDATED_BY_MERGE;
-    else if (label == "ADDED_BY_INTEGRATE")
-        flags = Constants::FSTATUS_ADDED_BY_INTEGRATE;
-    else if (label == "UPDATED_BY_INTEGRATE")
-        flags = Constants::FSTATUS_UPDATED_BY_INTEGRATE;
-    else if (label == "CONFLICT")
-        flags = "Conflict";
-    else if (label == "EXECUTABLE")
-        flags = "Set Exec";
-    else if (label == "SYMLINK")
-        flags = "Set Symlink";
-    else if (label == "UNEXEC")
-        flags = "Unset Exec";
-    else if (label == "UNLINK")
-        flags = "Unset Symlink";
-    else if (label == "NOT_A_FILE")
-        flags = Constants::FSTATUS_UNKNOWN;
-
-
-    if (flags.isEmpty())
-        return StatusItem();
-
-    // adjust the position to the last space before the file name
-    for (int size = line.size(); (pos+1) < size && line[pos+1].isSpace(); ++pos) {}
-
-    item.flags = flags;
-    item.file = line.mid(pos + 1);
-
-    return item;
+    return OutputParser::parseStatusLine(line);
 }
 
 VcsBase::VcsBaseEditorConfig *FossilClient::createAnnotateEditor(VcsBase::VcsBaseEditorWidget *editor)
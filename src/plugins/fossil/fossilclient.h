@@ -29,14 +29,30 @@
 #include "fossilsettings.h"
 #include "branchinfo.h"
 #include "revisioninfo.h"
+#include "revisioncache.h"
+#include "annotationcache.h"
+#include "artifactcache.h"
+#include "diffcache.h"
+#include "commandtracer.h"
+#include "jobscheduler.h"
+#include "managedfileindex.h"
+#include "singleflight.h"
+#include "toplevelcache.h"
 
 #include <vcsbase/vcsbaseclient.h>
 
+#include <QAtomicInt>
+#include <QFuture>
+#include <QHash>
 #include <QList>
+#include <QMutex>
+#include <QThreadPool>
 
 namespace Fossil {
 namespace Internal {
 
+class RepositoryDatabase;
+
 class FossilSettings;
 class FossilPluginPrivate;
 
@@ -51,6 +67,8 @@ public:
         TimelinePathFeature = 0x10,
         AnnotateRevisionFeature = 0x20,
         InfoHashFeature = 0x40,
+        BranchListAllFeature = 0x80,
+        ChangesPathsFeature = 0x100,
         AllSupportedFeatures =  // | all defined features
             AnnotateBlameFeature
             | TimelineWidthFeature
@@ -58,6 +76,8 @@ public:
             | TimelinePathFeature
             | AnnotateRevisionFeature
             | InfoHashFeature
+            | BranchListAllFeature
+            | ChangesPathsFeature
     };
     Q_DECLARE_FLAGS(SupportedFeatures, SupportedFeature)
 
@@ -67,20 +87,65 @@ public:
     explicit FossilClient(FossilSettings *settings);
 
     unsigned int synchronousBinaryVersion() const;
-    BranchInfo synchronousCurrentBranch(const QString &workingDirectory);
-    QList<BranchInfo> synchronousBranchQuery(const QString &workingDirectory);
+    BranchInfo synchronousCurrentBranch(const QString &workingDirectory) const;
+    QList<BranchInfo> synchronousBranchQuery(const QString &workingDirectory) const;
     RevisionInfo synchronousRevisionQuery(const QString &workingDirectory, const QString &id = QString(),
                                           bool getCommentMsg = false) const;
-    QStringList synchronousTagQuery(const QString &workingDirectory, const QString &id = QString());
-    RepositorySettings synchronousSettingsQuery(const QString &workingDirectory);
+    QStringList synchronousTagQuery(const QString &workingDirectory, const QString &id = QString()) const;
+    RepositorySettings synchronousSettingsQuery(const QString &workingDirectory) const;
     bool synchronousSetSetting(const QString &workingDirectory, const QString &property,
                                const QString &value = QString(), bool isGlobal = false);
     bool synchronousConfigureRepository(const QString &workingDirectory, const RepositorySettings &newSettings,
                                         const RepositorySettings &currentSettings = RepositorySettings());
-    QString synchronousUserDefaultQuery(const QString &workingDirectory);
+    QString synchronousUserDefaultQuery(const QString &workingDirectory) const;
     bool synchronousSetUserDefault(const QString &workingDirectory, const QString &userName);
-    QString synchronousGetRepositoryURL(const QString &workingDirectory);
-    QString synchronousTopic(const QString &workingDirectory);
+    QString synchronousGetRepositoryURL(const QString &workingDirectory) const;
+    QString synchronousTopic(const QString &workingDirectory) const;
+    bool synchronousStatusQuery(const QString &workingDirectory, const QStringList &paths,
+                                QList<StatusItem> *items) const;
+    bool synchronousManagedFilesQuery(const QString &topLevel, QStringList *files) const;
+    QSharedPointer<const BlameLines> synchronousBlameQuery(const QString &file) const;
+    bool synchronousFileRevisionQuery(const QString &file, const QString &revision,
+                                      QByteArray *content) const;
+
+    // Asynchronous variants of the queries above, run on the client's query pool
+    QFuture<BranchInfo> currentBranchQuery(const QString &workingDirectory) const;
+    QFuture<QList<BranchInfo>> branchQuery(const QString &workingDirectory) const;
+    QFuture<RevisionInfo> revisionQuery(const QString &workingDirectory, const QString &id = QString(),
+                                        bool getCommentMsg = false) const;
+    QFuture<QStringList> tagQuery(const QString &workingDirectory, const QString &id = QString()) const;
+    QFuture<RepositorySettings> settingsQuery(const QString &workingDirectory) const;
+    QFuture<QString> userDefaultQuery(const QString &workingDirectory) const;
+    QFuture<QString> repositoryUrlQuery(const QString &workingDirectory) const;
+    QFuture<QString> topicQuery(const QString &workingDirectory) const;
+    // Reports no result when the status could not be obtained
+    QFuture<QList<StatusItem>> statusQuery(const QString &workingDirectory,
+                                           const QStringList &paths = QStringList()) const;
+    // Blame of the file as of the current check-out, null when not available
+    QFuture<QSharedPointer<const BlameLines>> blameQuery(const QString &file) const;
+    // Content of the file as committed in the revision, no result when not available
+    QFuture<QByteArray> fileRevisionQuery(const QString &file, const QString &revision) const;
+
+    // Run the command through the job scheduler. A job of the same owner,
+    // such as an editor, supersedes the earlier one, which is canceled.
+    void enqueueFossilJob(VcsBase::VcsCommand *cmd, const QStringList &args,
+                          JobScheduler::Priority priority = JobScheduler::Interactive,
+                          const QObject *owner = nullptr) const;
+    void cancelJobs(const QObject *owner) const;
+
+    // Takes over the settings read by the queries on the query pool.
+    // Settings are owned by the GUI thread, call it there whenever they change.
+    void applySettings();
+
+    // Details of the revision in the cache of the repository, never queried
+    Utils::optional<RevisionInfo> cachedRevision(const QString &workingDirectory,
+                                                 const QString &id) const;
+    // Identifies the repository of the check-out
+    QString repositoryKey(const QString &workingDirectory) const;
+    CommandTracer &tracer() const;
+    ManagedFileIndex &managedFileIndex() const;
+    TopLevelCache &topLevelCache() const;
+
     bool synchronousCreateRepository(const QString &workingDirectory,
                                      const QStringList &extraOptions = QStringList()) final;
     bool synchronousMove(const QString &workingDir,
@@ -92,6 +157,11 @@ public:
     bool synchronousPush(const QString &workingDir,
                          const QString &dstLocation,
                          const QStringList &extraOptions = QStringList()) final;
+    // Non-blocking variants of the above, reporting the transfer progress
+    void pull(const QString &workingDir, const QString &srcLocation,
+              const QStringList &extraOptions = QStringList());
+    void push(const QString &workingDir, const QString &dstLocation,
+              const QStringList &extraOptions = QStringList());
     void commit(const QString &repositoryRoot, const QStringList &files,
                 const QString &commitMessageFile, const QStringList &extraOptions = QStringList()) final;
     VcsBase::VcsBaseEditorWidget *annotate(
@@ -118,9 +188,39 @@ public:
               const QStringList &extraOptions = QStringList()) final;
 
 private:
-    static QList<BranchInfo> branchListFromOutput(const QString &output, const BranchInfo::BranchFlags defaultFlags = {});
-    static QStringList parseRevisionCommentLine(const QString &commentLine);
+    struct BinaryInfo {
+        unsigned int version = 0;
+        SupportedFeatures features;
+    };
+
 
+    static SupportedFeatures featuresForVersion(unsigned int version);
+    static QString binaryFingerprint(const QString &binaryPath);
+
+    BinaryInfo probeBinary() const;
+    void storeBinaryVersion(const QString &fingerprint, unsigned int version) const;
+    QList<BranchInfo> queryBranches(const QString &workingDirectory) const;
+    RevisionInfo queryRevision(const QString &workingDirectory, const QString &id,
+                               bool getCommentMsg) const;
+    QStringList queryTags(const QString &workingDirectory, const QString &id) const;
+    // The default user is of the plugin settings, read by the caller on the GUI thread
+    RepositorySettings querySettings(const QString &workingDirectory,
+                                     const QString &defaultUser) const;
+    bool queryArtifact(const QString &workingDirectory, const QString &id,
+                       QByteArray *content) const;
+    // Identifies the identical requests, for them to be coalesced
+    QString flightKey(const QString &workingDirectory, const QStringList &args) const;
+    // Null when the database backend is disabled or not usable for the check-out
+    QSharedPointer<const RepositoryDatabase> repositoryDatabase(const QString &workingDirectory) const;
+    // The disk cache, its size limit is set by applySettings()
+    ArtifactCache &artifactCache() const;
+    void enqueueViewDiff(VcsBase::VcsBaseEditorWidget *editor, const QString &workingDirectory,
+                         const QStringList &args, const QString &diffKey) const;
+    // Traced variants of the command execution helpers
+    Utils::SynchronousProcessResponse runFossil(const QString &workingDirectory,
+                                                const QStringList &args, unsigned flags = 0) const;
+    QString fossilOutput(const Utils::SynchronousProcessResponse &response) const;
+    void enqueueSync(const QString &workingDir, const QStringList &args);
     QString sanitizeFossilOutput(const QString &output) const;
     QString vcsCommandString(VcsCommandTag cmd) const final;
     Core::Id vcsEditorKind(VcsCommandTag cmd) const final;
@@ -130,6 +230,29 @@ private:
     VcsBase::VcsBaseEditorConfig *createLogCurrentFileEditor(VcsBase::VcsBaseEditorWidget *editor);
     VcsBase::VcsBaseEditorConfig *createLogEditor(VcsBase::VcsBaseEditorWidget *editor);
 
+    mutable QThreadPool m_queryPool;
+    QAtomicInt m_useDatabaseBackend;
+    mutable QMutex m_binaryInfoMutex;
+    mutable BinaryInfo m_binaryInfo;
+    mutable QString m_binaryInfoPath;
+    // Settings copied by applySettings(), guarded by the binary info mutex
+    QString m_binaryPath;
+    mutable QString m_storedBinaryFingerprint;
+    mutable unsigned int m_storedBinaryVersion = 0;
+    mutable RevisionCache m_revisionCache;
+    mutable QMutex m_repositoryKeysMutex;
+    mutable QHash<QString, QString> m_repositoryKeys; // by the check-out
+    mutable CommandTracer m_tracer;
+    mutable ManagedFileIndex m_managedFileIndex;
+    mutable TopLevelCache m_topLevelCache;
+    mutable AnnotationCache m_annotationCache;
+    mutable ArtifactCache m_artifactCache;
+    mutable DiffCache m_diffCache;
+    mutable JobScheduler m_jobScheduler;
+    mutable SingleFlight<QList<BranchInfo>> m_branchFlights;
+    mutable SingleFlight<RevisionInfo> m_revisionFlights;
+    mutable SingleFlight<QStringList> m_tagFlights;
+
     friend class FossilPluginPrivate;
 };
 
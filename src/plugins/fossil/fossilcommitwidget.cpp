@@ -102,14 +102,57 @@ void FossilCommitWidget::setFields(const QString &repoPath, const BranchInfo &br
                                    const QStringList &tags, const QString &userName)
 {
     m_commitPanelUi.localRootLineEdit->setText(QDir::toNativeSeparators(repoPath));
-    m_commitPanelUi.currentBranchLineEdit->setText(branch.name());
-    const QString tagsText = tags.join(", ");
-    m_commitPanelUi.currentTagsLineEdit->setText(tagsText);
-    m_commitPanelUi.authorLineEdit->setText(userName);
+    setCurrentBranch(branch);
+    setCurrentTags(tags);
+    setUserName(userName);
 
     branchChanged();
 }
 
+void FossilCommitWidget::setFieldsPending(const QString &repoPath)
+{
+    m_commitPanelUi.localRootLineEdit->setText(QDir::toNativeSeparators(repoPath));
+
+    const QString pending = tr("Querying...");
+    m_commitPanelUi.currentBranchLineEdit->setPlaceholderText(pending);
+    m_commitPanelUi.currentTagsLineEdit->setPlaceholderText(pending);
+    m_commitPanelUi.authorLineEdit->setPlaceholderText(pending);
+
+    branchChanged();
+}
+
+void FossilCommitWidget::setCurrentBranch(const BranchInfo &branch)
+{
+    m_currentBranchName = branch.name();
+    m_commitPanelUi.currentBranchLineEdit->setPlaceholderText(QString());
+    m_commitPanelUi.currentBranchLineEdit->setText(m_currentBranchName);
+    updateCurrentTags();
+}
+
+void FossilCommitWidget::setCurrentTags(const QStringList &tags)
+{
+    m_currentTags = tags;
+    m_commitPanelUi.currentTagsLineEdit->setPlaceholderText(QString());
+    updateCurrentTags();
+}
+
+void FossilCommitWidget::setUserName(const QString &userName)
+{
+    m_commitPanelUi.authorLineEdit->setPlaceholderText(QString());
+    // Don't overwrite the author already entered while the query was running
+    if (m_commitPanelUi.authorLineEdit->text().isEmpty())
+        m_commitPanelUi.authorLineEdit->setText(userName);
+}
+
+void FossilCommitWidget::updateCurrentTags()
+{
+    // Fossil includes branch name in tag list -- remove.
+    QStringList tags = m_currentTags;
+    if (!m_currentBranchName.isEmpty())
+        tags.removeAll(m_currentBranchName);
+    m_commitPanelUi.currentTagsLineEdit->setText(tags.join(", "));
+}
+
 QString FossilCommitWidget::newBranch() const
 {
     const QString branchName = m_commitPanelUi.branchLineEdit->text().trimmed();
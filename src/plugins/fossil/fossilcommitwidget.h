@@ -54,6 +54,12 @@ public:
     void setFields(const QString &repoPath,
                    const BranchInfo &newBranch, const QStringList &tags, const QString &userName);
 
+    // Fields which are filled in once the corresponding query completes
+    void setFieldsPending(const QString &repoPath);
+    void setCurrentBranch(const BranchInfo &branch);
+    void setCurrentTags(const QStringList &tags);
+    void setUserName(const QString &userName);
+
     QString newBranch() const;
     QStringList tags() const;
     QString committer() const;
@@ -67,10 +73,13 @@ private slots:
 
 private:
     bool isValidBranch() const;
+    void updateCurrentTags();
 
     QWidget *m_commitPanel;
     Ui::FossilCommitPanel m_commitPanelUi;
     QValidator *m_branchValidator;
+    QString m_currentBranchName;
+    QStringList m_currentTags;
 };
 
 } // namespace Internal
@@ -29,11 +29,18 @@
 #include "constants.h"
 #include "fossilplugin.h"
 #include "fossilclient.h"
+#include "loghighlighter.h"
 
 #include <coreplugin/editormanager/editormanager.h>
+#include <coreplugin/editormanager/ieditor.h>
+#include <coreplugin/idocument.h>
+#include <utils/runextensions.h>
 #include <utils/qtcassert.h>
 #include <utils/synchronousprocess.h>
+#include <texteditor/textdocument.h>
+#include <vcsbase/baseannotationhighlighter.h>
 #include <vcsbase/diffandloghighlighter.h>
+#include <vcsbase/vcsoutputwindow.h>
 
 #include <QRegularExpression>
 #include <QRegExp>
@@ -42,30 +49,68 @@
 #include <QTextBlock>
 #include <QDir>
 #include <QFileInfo>
+#include <QMenu>
+#include <QScrollBar>
+#include <QSet>
+#include <QTimer>
 
 namespace Fossil {
 namespace Internal {
 
+// Delay of the revision prefetch after the cursor, the view or the text changes
+const int prefetchDelayMs = 200;
+// Most revisions queried by a single prefetch
+const int maxPrefetchedRevisions = 16;
+
+const char logEntryPattern[] = "^.*\\[([0-9a-f]{5,40})\\]";
+
 class FossilEditorWidgetPrivate
 {
 public:
     FossilEditorWidgetPrivate() :
-        m_exactChangesetId(Constants::CHANGESET_ID_EXACT)
+        m_exactChangesetId(Constants::CHANGESET_ID_EXACT),
+        m_logEntry(logEntryPattern),
+        m_lineChanges(new AnnotationLineChanges)
     {
         QTC_ASSERT(m_exactChangesetId.isValid(), return);
+        QTC_ASSERT(m_logEntry.isValid(), return);
     }
 
 
     const QRegularExpression m_exactChangesetId;
+    const QRegularExpression m_logEntry;
+
+    // The context menu answers from the revision cache, kept warm by the prefetch
+    QTimer m_prefetchTimer;
+    QSet<QString> m_failedRevisions;    // not queried again
+
+    FossilLogHighlighter *m_logHighlighter = nullptr;
+
+    // Streamed annotation state, the line changes are shared with the highlighter
+    const QSharedPointer<AnnotationLineChanges> m_lineChanges;
+    int m_pendingLine = -1;     // line to go to once it arrives
+    int m_nextBlock = 0;        // first block not scanned for changes yet
+    bool m_isStreaming = false;
 };
 
 FossilEditorWidget::FossilEditorWidget() :
     d(new FossilEditorWidgetPrivate)
 {
+    d->m_prefetchTimer.setSingleShot(true);
+    d->m_prefetchTimer.setInterval(prefetchDelayMs);
+    connect(&d->m_prefetchTimer, &QTimer::timeout, this, &FossilEditorWidget::prefetchRevisions);
+    const auto schedulePrefetch = [this] {
+        if (!d->m_prefetchTimer.isActive())
+            d->m_prefetchTimer.start();
+    };
+    connect(this, &QPlainTextEdit::cursorPositionChanged, this, schedulePrefetch);
+    connect(this, &QPlainTextEdit::textChanged, this, schedulePrefetch);
+    connect(verticalScrollBar(), &QScrollBar::valueChanged, this, schedulePrefetch);
+
     setAnnotateRevisionTextFormat(tr("&Annotate %1"));
     setAnnotatePreviousRevisionTextFormat(tr("Annotate &Parent Revision %1"));
     setDiffFilePattern(Constants::DIFFFILE_ID_EXACT);
-    setLogEntryPattern("^.*\\[([0-9a-f]{5,40})\\]");
+    setLogEntryPattern(logEntryPattern);
     setAnnotationEntryPattern(QString("^") + Constants::CHANGESET_ID + " ");
 }
 
@@ -74,6 +119,13 @@ FossilEditorWidget::~FossilEditorWidget()
     delete d;
 }
 
+void FossilEditorWidget::enableLogHighlighting()
+{
+    // Owned by the document
+    if (!d->m_logHighlighter)
+        d->m_logHighlighter = new FossilLogHighlighter(document());
+}
+
 QString FossilEditorWidget::changeUnderCursor(const QTextCursor &cursorIn) const
 {
     QTextCursor cursor = cursorIn;
@@ -92,11 +144,10 @@ QString FossilEditorWidget::decorateVersion(const QString &revision) const
     static const int shortChangesetIdSize(10);
     static const int maxTextSize(120);
 
-    const QFileInfo fi(source());
-    const QString workingDirectory = fi.absolutePath();
-    const FossilClient *client = FossilPlugin::client();
-    RevisionInfo revisionInfo =
-            client->synchronousRevisionQuery(workingDirectory, revision, true);
+    const Utils::optional<RevisionInfo> menuInfo = menuRevision(revision);
+    if (!menuInfo)
+        return revision;
+    const RevisionInfo &revisionInfo = *menuInfo;
 
     // format: 'revision (committer "comment...")'
     QString output = revision.left(shortChangesetIdSize)
@@ -114,11 +165,10 @@ QString FossilEditorWidget::decorateVersion(const QString &revision) const
 QStringList FossilEditorWidget::annotationPreviousVersions(const QString &revision) const
 {
     QStringList revisions;
-    const QFileInfo fi(source());
-    const QString workingDirectory = fi.absolutePath();
-    const FossilClient *client = FossilPlugin::client();
-    RevisionInfo revisionInfo =
-            client->synchronousRevisionQuery(workingDirectory, revision);
+    const Utils::optional<RevisionInfo> menuInfo = menuRevision(revision);
+    if (!menuInfo)
+        return QStringList();
+    const RevisionInfo &revisionInfo = *menuInfo;
     if (revisionInfo.parentId.isEmpty())
         return QStringList();
 
@@ -127,10 +177,206 @@ QStringList FossilEditorWidget::annotationPreviousVersions(const QString &revisi
     return revisions;
 }
 
+QString FossilEditorWidget::blockChange(const QTextBlock &block) const
+{
+    if (contentType() == VcsBase::AnnotateOutput) {
+        const QString change = d->m_lineChanges->change(block.blockNumber());
+        if (!change.isEmpty())
+            return change;
+        const QString text = block.text();
+        return text.left(AnnotationLineChanges::changeIdLength(text));
+    }
+    return d->m_logEntry.match(block.text()).captured(1);
+}
+
+void FossilEditorWidget::prefetchRevisions()
+{
+    // Query the changes in view and under the cursor ahead of the context menu,
+    // which takes the revision details from the cache only.
+    // Not while the annotation streams in, the lines keep moving.
+    if (contentType() != VcsBase::LogOutput && contentType() != VcsBase::AnnotateOutput)
+        return;
+    if (d->m_isStreaming)
+        return;
+
+    QStringList changes;
+    const auto addChange = [this, &changes](const QString &change) {
+        if (!change.isEmpty() && !changes.contains(change)
+                && !d->m_failedRevisions.contains(change) && !cachedRevision(change)) {
+            changes.append(change);
+        }
+    };
+
+    addChange(changeUnderCursor(textCursor()));
+    const int viewportBottom = viewport()->rect().bottom();
+    for (QTextBlock block = firstVisibleBlock();
+         block.isValid() && changes.size() < maxPrefetchedRevisions; block = block.next()) {
+        if (blockBoundingGeometry(block).translated(contentOffset()).top() > viewportBottom)
+            break;
+        addChange(blockChange(block));
+    }
+
+    const FossilClient *client = FossilPlugin::client();
+    for (const QString &change : qAsConst(changes)) {
+        const QFuture<RevisionInfo> future = client->revisionQuery(sourceDirectory(), change, true);
+        Utils::onResultReady(future, this, [this, change](const RevisionInfo &revisionInfo) {
+            if (revisionInfo.id.isEmpty())
+                d->m_failedRevisions.insert(change);
+        });
+    }
+}
+
+QString FossilEditorWidget::sourceDirectory() const
+{
+    const QFileInfo fi(source());
+    return fi.isFile() ? fi.absolutePath() : source();
+}
+
+Utils::optional<RevisionInfo> FossilEditorWidget::cachedRevision(const QString &revision) const
+{
+    return FossilPlugin::client()->cachedRevision(sourceDirectory(), revision);
+}
+
+Utils::optional<RevisionInfo> FossilEditorWidget::menuRevision(const QString &revision) const
+{
+    // Mostly prefetched, a change not in the cache yet is queried on its own
+    if (const Utils::optional<RevisionInfo> cachedInfo = cachedRevision(revision))
+        return cachedInfo;
+    if (d->m_failedRevisions.contains(revision))
+        return Utils::nullopt;
+
+    const RevisionInfo revisionInfo
+            = FossilPlugin::client()->synchronousRevisionQuery(sourceDirectory(), revision, true);
+    if (revisionInfo.id.isEmpty()) {
+        d->m_failedRevisions.insert(revision);
+        return Utils::nullopt;
+    }
+    return revisionInfo;
+}
+
+void FossilEditorWidget::addChangeActions(QMenu *menu, const QString &change)
+{
+    // The log and the annotation of a single file
+    if (!QFileInfo(source()).isFile())
+        return;
+
+    menu->addSeparator();
+    menu->addAction(tr("Show File at Revision %1").arg(change), this, [this, change] {
+        showFileAtRevision(change);
+    });
+}
+
+void FossilEditorWidget::showFileAtRevision(const QString &revision)
+{
+    const QString file = source();
+    const QFuture<QByteArray> future = FossilPlugin::client()->fileRevisionQuery(file, revision);
+    Utils::onFinished(future, this, [file, revision](const QFuture<QByteArray> &future) {
+        const QFileInfo fi(file);
+        if (future.resultCount() == 0) {
+            VcsBase::VcsOutputWindow::appendError(
+                        tr("Cannot show \"%1\" at revision %2.").arg(fi.fileName(), revision));
+            return;
+        }
+
+        // "name@revision.ext", for the editor to match the file type
+        QString title = fi.completeBaseName() + '@' + revision;
+        if (!fi.suffix().isEmpty())
+            title += '.' + fi.suffix();
+        Core::IEditor *editor = Core::EditorManager::openEditorWithContents(
+                    Core::Id(), &title, future.result(), file + '@' + revision);
+        if (editor)
+            editor->document()->setTemporary(true);
+    });
+}
+
+void FossilEditorWidget::beginStreamedOutput(int lineNumber)
+{
+    d->m_lineChanges->clear();
+    d->m_pendingLine = lineNumber;
+    d->m_nextBlock = 0;
+    d->m_isStreaming = true;
+    d->m_prefetchTimer.stop();
+
+    // The lines are colored as they are inserted, no pass over the whole document
+    // is made before the output is complete.
+    FossilAnnotationHighlighter *highlighter = annotationHighlighter();
+    if (!highlighter) {
+        highlighter = new FossilAnnotationHighlighter(QSet<QString>());
+        highlighter->setLineChanges(d->m_lineChanges);
+        textDocument()->setSyntaxHighlighter(highlighter);
+    }
+    highlighter->setStreaming(true);
+
+    // Appending chunks to a large document must not grow the undo stack
+    document()->setUndoRedoEnabled(false);
+    textDocument()->setPlainText(QString());
+}
+
+void FossilEditorWidget::appendStreamedOutput(const QString &text)
+{
+    if (text.isEmpty())
+        return;
+
+    // Append without moving the cursor or the view of the user
+    QTextCursor cursor(document());
+    cursor.movePosition(QTextCursor::End);
+    cursor.insertText(text);
+
+    collectAnnotationChanges(false);
+
+    if (d->m_pendingLine > 0 && d->m_pendingLine < document()->blockCount()) {
+        gotoLine(d->m_pendingLine);
+        d->m_pendingLine = -1;
+    }
+}
+
+void FossilEditorWidget::finishStreamedOutput()
+{
+    collectAnnotationChanges(true);
+
+    // A single pass over the complete annotation, in the colors of all its changes
+    if (FossilAnnotationHighlighter *highlighter = annotationHighlighter()) {
+        highlighter->setStreaming(false);
+        highlighter->setChangeNumbers(d->m_lineChanges->changes());
+        highlighter->rehighlight();
+    }
+
+    if (d->m_pendingLine > 0) {
+        gotoLine(d->m_pendingLine);
+        d->m_pendingLine = -1;
+    }
+    document()->setModified(false);
+
+    d->m_isStreaming = false;
+    d->m_prefetchTimer.start();
+}
+
+void FossilEditorWidget::collectAnnotationChanges(bool complete)
+{
+    // Scan only the lines appended since the last chunk.
+    // The last line may still be incomplete, leave it for the next chunk.
+    const int endBlock = complete ? document()->blockCount() : document()->blockCount() - 1;
+    for (QTextBlock block = document()->findBlockByNumber(d->m_nextBlock);
+         block.isValid() && block.blockNumber() < endBlock; block = block.next()) {
+        const QString text = block.text();
+        const int length = AnnotationLineChanges::changeIdLength(text);
+        if (length > 0)
+            d->m_lineChanges->setChange(block.blockNumber(), text.left(length));
+    }
+    d->m_nextBlock = qMax(d->m_nextBlock, endBlock);
+}
+
+FossilAnnotationHighlighter *FossilEditorWidget::annotationHighlighter() const
+{
+    return dynamic_cast<FossilAnnotationHighlighter *>(textDocument()->syntaxHighlighter());
+}
+
 VcsBase::BaseAnnotationHighlighter *FossilEditorWidget::createAnnotationHighlighter(
         const QSet<QString> &changes) const
 {
-    return new FossilAnnotationHighlighter(changes);
+    auto highlighter = new FossilAnnotationHighlighter(changes);
+    highlighter->setLineChanges(d->m_lineChanges);
+    return highlighter;
 }
 
 } // namespace Internal
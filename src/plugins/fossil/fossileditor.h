@@ -26,11 +26,19 @@
 
 #pragma once
 
+#include "revisioninfo.h"
+
+#include <utils/optional.h>
 #include <vcsbase/vcsbaseeditor.h>
 
+QT_BEGIN_NAMESPACE
+class QTextBlock;
+QT_END_NAMESPACE
+
 namespace Fossil {
 namespace Internal {
 
+class FossilAnnotationHighlighter;
 class FossilEditorWidgetPrivate;
 
 class FossilEditorWidget : public VcsBase::VcsBaseEditorWidget
@@ -41,12 +49,29 @@ public:
     FossilEditorWidget();
     ~FossilEditorWidget() final;
 
+    // A single log highlighter is kept across the reloads of the log
+    void enableLogHighlighting();
+
+    // Annotation output shown as it arrives, instead of all at once
+    void beginStreamedOutput(int lineNumber);
+    void appendStreamedOutput(const QString &text);
+    void finishStreamedOutput();
+
 private:
     QString changeUnderCursor(const QTextCursor &cursor) const final;
     QString decorateVersion(const QString &revision) const final;
     QStringList annotationPreviousVersions(const QString &revision) const final;
+    void addChangeActions(QMenu *menu, const QString &change) final;
     VcsBase::BaseAnnotationHighlighter *createAnnotationHighlighter(
             const QSet<QString> &changes) const final;
+    void collectAnnotationChanges(bool complete);
+    FossilAnnotationHighlighter *annotationHighlighter() const;
+    void showFileAtRevision(const QString &revision);
+    QString blockChange(const QTextBlock &block) const;
+    void prefetchRevisions();
+    QString sourceDirectory() const;
+    Utils::optional<RevisionInfo> cachedRevision(const QString &revision) const;
+    Utils::optional<RevisionInfo> menuRevision(const QString &revision) const;
 
     FossilEditorWidgetPrivate *d;
 };
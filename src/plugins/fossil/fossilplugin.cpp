@@ -25,14 +25,20 @@
 **************************************************************************/
 
 #include "fossilplugin.h"
+#include "autopullscheduler.h"
 #include "constants.h"
 #include "fossilclient.h"
 #include "optionspage.h"
 #include "fossilcommitwidget.h"
 #include "fossileditor.h"
+#include "inlineblame.h"
+#include "multicheckoutrunner.h"
 #include "pullorpushdialog.h"
 #include "configuredialog.h"
 #include "commiteditor.h"
+#include "statusmodel.h"
+#include "timelinemodel.h"
+#include "timelinewidget.h"
 #include "wizard/fossiljsextension.h"
 
 #include "ui_revertdialog.h"
@@ -54,10 +60,13 @@
 #include <projectexplorer/projectexplorer.h>
 #include <projectexplorer/projecttree.h>
 #include <projectexplorer/project.h>
+#include <projectexplorer/session.h>
 #include <projectexplorer/jsonwizard/jsonwizardfactory.h>
 
+#include <utils/fileutils.h>
 #include <utils/parameteraction.h>
 #include <utils/qtcassert.h>
+#include <utils/runextensions.h>
 
 #include <vcsbase/basevcseditorfactory.h>
 #include <vcsbase/basevcssubmiteditorfactory.h>
@@ -68,12 +77,14 @@
 #include <vcsbase/vcsoutputwindow.h>
 
 #include <QtPlugin>
+#include <QApplication>
 #include <QAction>
 #include <QMenu>
 #include <QDir>
 #include <QDialog>
 #include <QMessageBox>
 #include <QFileDialog>
+#include <QPointer>
 #include <QRegularExpression>
 
 using namespace Core;
@@ -195,10 +206,19 @@ public:
     void update();
     void configureRepository();
     void commit();
-    void showCommitWidget(const QList<VcsBase::VcsBaseClient::StatusItem> &status);
+    void commitStatusReady(const QList<VcsBase::VcsBaseClient::StatusItem> &status);
+    CommitEditor *showCommitWidget(const QList<VcsBase::VcsBaseClient::StatusItem> &status);
     void commitFromEditor() override;
     void diffFromEditorSelected(const QStringList &files);
     void createRepository();
+    void exportTrace();
+    void showAutoPullStatus();
+    void statusAllCheckouts();
+    void pullAllCheckouts();
+    void updateAllCheckouts();
+    void runForAllCheckouts(const QString &title, const QStringList &args, bool expectRepoChanges,
+                            bool perRepository = false);
+    QStringList openCheckouts() const;
 
     // Methods
     void createMenu(const Core::Context &context);
@@ -213,6 +233,9 @@ public:
     // Variables
     FossilSettings m_fossilSettings;
     FossilClient m_client{&m_fossilSettings};
+    StatusModel m_statusModel{&m_client};
+    InlineBlame m_inlineBlame{&m_client};
+    AutoPullScheduler m_autoPullScheduler{&m_client};
 
     OptionsPage optionPage{[this] { configurationChanged(); }, &m_fossilSettings};
 
@@ -240,6 +263,12 @@ public:
         std::bind(&FossilPluginPrivate::describe, this, _1, _2)
     };
 
+    TimelineNavigationWidgetFactory timelineFactory {
+        &m_client,
+        [this] { return currentState().topLevel(); },
+        std::bind(&FossilPluginPrivate::describe, this, _1, _2)
+    };
+
     Core::CommandLocator *m_commandLocator = nullptr;
     Core::ActionContainer *m_fossilContainer = nullptr;
 
@@ -262,6 +291,15 @@ public:
     QString m_submitRepository;
     bool m_submitActionTriggered = false;
 
+    // Commit editor fields, queried while the status is being collected
+    struct CommitQueries {
+        QFuture<RevisionInfo> revision;
+        QFuture<BranchInfo> branch;
+        QFuture<QString> user;
+    } m_commitQueries;
+    // Opened with the status snapshot, its file list awaits the status query
+    QPointer<CommitEditor> m_prefilledCommitEditor;
+
     // To be connected to the VcsTask's success signal to emit the repository/
     // files changed signals according to the variant's type:
     // String -> repository, StringList -> files
@@ -313,6 +351,36 @@ FossilPluginPrivate::FossilPluginPrivate()
     setTopicCache(new FossilTopicCache(&m_client));
     connect(&m_client, &VcsBase::VcsBaseClient::changed, this, &FossilPluginPrivate::changed);
 
+    // Keep the status snapshots up to date with the edits made in and outside of the IDE
+    connect(Core::EditorManager::instance(), &Core::EditorManager::saved,
+            this, [this](Core::IDocument *document) {
+        m_statusModel.invalidateFiles(QStringList(document->filePath().toString()));
+    });
+    connect(qApp, &QGuiApplication::applicationStateChanged,
+            this, [this](Qt::ApplicationState state) {
+        if (state == Qt::ApplicationActive)
+            m_statusModel.invalidateChanged();
+    });
+
+    m_client.applySettings();
+    m_inlineBlame.setEnabled(m_fossilSettings.boolValue(FossilSettings::inlineBlameKey));
+    m_autoPullScheduler.setInterval(m_fossilSettings.intValue(FossilSettings::autoPullIntervalKey));
+    connect(this, &Core::IVersionControl::configurationChanged, this, [this] {
+        m_client.applySettings();
+        m_inlineBlame.setEnabled(m_fossilSettings.boolValue(FossilSettings::inlineBlameKey));
+        m_autoPullScheduler.setInterval(m_fossilSettings.intValue(FossilSettings::autoPullIntervalKey));
+    });
+
+    // Keep the auto-pull schedule and the status snapshots in line with the open projects
+    ProjectExplorer::SessionManager *sessionManager = ProjectExplorer::SessionManager::instance();
+    const auto updateProjectCheckouts = [this] {
+        const QStringList topLevels = openCheckouts();
+        m_autoPullScheduler.setCheckouts(topLevels);
+        m_statusModel.setProjectCheckouts(topLevels);
+    };
+    connect(sessionManager, &ProjectExplorer::SessionManager::projectAdded, this, updateProjectCheckouts);
+    connect(sessionManager, &ProjectExplorer::SessionManager::projectRemoved, this, updateProjectCheckouts);
+
     m_commandLocator = new Core::CommandLocator("Fossil", "fossil", "fossil", this);
 
     ProjectExplorer::JsonWizardFactory::addWizardPath(Utils::FilePath::fromString(Constants::WIZARD_PATH));
@@ -606,6 +674,36 @@ void FossilPluginPrivate::createRepositoryActions(const Core::Context &context)
     command = Core::ActionManager::registerAction(m_createRepositoryAction, Constants::CREATE_REPOSITORY);
     connect(m_createRepositoryAction, &QAction::triggered, this, &FossilPluginPrivate::createRepository);
     m_fossilContainer->addAction(command);
+
+    // Command trace is collected across all repositories, keep it in global context too.
+    action = new QAction(tr("Export Command Trace..."), this);
+    command = Core::ActionManager::registerAction(action, Constants::EXPORT_TRACE);
+    connect(action, &QAction::triggered, this, &FossilPluginPrivate::exportTrace);
+    m_fossilContainer->addAction(command);
+
+    action = new QAction(tr("Show Auto-Pull Status"), this);
+    command = Core::ActionManager::registerAction(action, Constants::AUTO_PULL_STATUS);
+    connect(action, &QAction::triggered, this, &FossilPluginPrivate::showAutoPullStatus);
+    m_fossilContainer->addAction(command);
+
+    // Check-outs of all open projects, regardless of the current one.
+    action = new QAction(tr("Status for All Check-outs"), this);
+    command = Core::ActionManager::registerAction(action, Constants::STATUS_ALL_CHECKOUTS);
+    connect(action, &QAction::triggered, this, &FossilPluginPrivate::statusAllCheckouts);
+    m_fossilContainer->addAction(command);
+    m_commandLocator->appendCommand(command);
+
+    action = new QAction(tr("Pull All Check-outs"), this);
+    command = Core::ActionManager::registerAction(action, Constants::PULL_ALL_CHECKOUTS);
+    connect(action, &QAction::triggered, this, &FossilPluginPrivate::pullAllCheckouts);
+    m_fossilContainer->addAction(command);
+    m_commandLocator->appendCommand(command);
+
+    action = new QAction(tr("Update All Check-outs"), this);
+    command = Core::ActionManager::registerAction(action, Constants::UPDATE_ALL_CHECKOUTS);
+    connect(action, &QAction::triggered, this, &FossilPluginPrivate::updateAllCheckouts);
+    m_fossilContainer->addAction(command);
+    m_commandLocator->appendCommand(command);
 }
 
 bool FossilPluginPrivate::pullOrPush(FossilPluginPrivate::SyncMode mode)
@@ -627,11 +725,16 @@ bool FossilPluginPrivate::pullOrPush(FossilPluginPrivate::SyncMode mode)
 
     PullOrPushDialog dialog(pullOrPushMode, Core::ICore::dialogParent());
     dialog.setLocalBaseDirectory(m_client.settings().stringValue(FossilSettings::defaultRepoPathKey));
-    const QString defaultURL(m_client.synchronousGetRepositoryURL(state.topLevel()));
-    dialog.setDefaultRemoteLocation(defaultURL);
+    // Don't hold up the dialog, fill in the remote location once it's known
+    const QFuture<QString> defaultURLFuture = m_client.repositoryUrlQuery(state.topLevel());
+    Utils::onResultReady(defaultURLFuture, &dialog, [&dialog](const QString &url) {
+        dialog.setDefaultRemoteLocation(url);
+    });
     if (dialog.exec() != QDialog::Accepted)
         return true;
 
+    const QString defaultURL(defaultURLFuture.result());
+
     QString remoteLocation(dialog.remoteLocation());
     if (remoteLocation.isEmpty() && defaultURL.isEmpty()) {
         VcsBase::VcsOutputWindow::appendError(tr("Remote repository is not defined."));
@@ -647,9 +750,11 @@ bool FossilPluginPrivate::pullOrPush(FossilPluginPrivate::SyncMode mode)
         extraOptions << "--private";
     switch (mode) {
     case SyncPull:
-        return m_client.synchronousPull(state.topLevel(), remoteLocation, extraOptions);
+        m_client.pull(state.topLevel(), remoteLocation, extraOptions);
+        return true;
     case SyncPush:
-        return m_client.synchronousPush(state.topLevel(), remoteLocation, extraOptions);
+        m_client.push(state.topLevel(), remoteLocation, extraOptions);
+        return true;
     default:
         return false;
     }
@@ -677,11 +782,16 @@ void FossilPluginPrivate::configureRepository()
     ConfigureDialog dialog;
 
     // retrieve current settings from the repository
-    RepositorySettings currentSettings = m_client.synchronousSettingsQuery(state.topLevel());
+    const QFuture<RepositorySettings> currentSettingsFuture = m_client.settingsQuery(state.topLevel());
+    dialog.setSettingsPending(true);
+    Utils::onResultReady(currentSettingsFuture, &dialog, [&dialog](const RepositorySettings &settings) {
+        dialog.setSettings(settings);
+        dialog.setSettingsPending(false);
+    });
 
-    dialog.setSettings(currentSettings);
     if (dialog.exec() != QDialog::Accepted)
         return;
+    const RepositorySettings currentSettings = currentSettingsFuture.result();
     const RepositorySettings newSettings = dialog.settings();
 
     m_client.synchronousConfigureRepository(state.topLevel(), newSettings, currentSettings);
@@ -700,22 +810,45 @@ void FossilPluginPrivate::commit()
 
     m_submitRepository = state.topLevel();
 
+    // Start the field queries now, so that they run alongside the status query
+    m_commitQueries.revision = m_client.revisionQuery(m_submitRepository);
+    m_commitQueries.branch = m_client.currentBranchQuery(m_submitRepository);
+    m_commitQueries.user = m_client.userDefaultQuery(m_submitRepository);
+
+    // The status snapshot only opens the editor early. It may miss the files written
+    // behind the back of the watchers, the file list is always taken from the status query.
+    m_prefilledCommitEditor.clear();
+    const Utils::optional<QList<VcsBaseClient::StatusItem>> snapshot
+            = m_statusModel.snapshot(m_submitRepository);
+    if (snapshot && !snapshot->isEmpty())
+        m_prefilledCommitEditor = showCommitWidget(*snapshot);
+
     connect(&m_client, &VcsBaseClient::parsedStatus,
-            this, &FossilPluginPrivate::showCommitWidget);
+            this, &FossilPluginPrivate::commitStatusReady);
 
     QStringList extraOptions;
     m_client.emitParsedStatus(m_submitRepository, extraOptions);
 }
 
-void FossilPluginPrivate::showCommitWidget(const QList<VcsBase::VcsBaseClient::StatusItem> &status)
+void FossilPluginPrivate::commitStatusReady(const QList<VcsBase::VcsBaseClient::StatusItem> &status)
 {
     //Once we receive our data release the connection so it can be reused elsewhere
     disconnect(&m_client, &VcsBaseClient::parsedStatus,
-               this, &FossilPluginPrivate::showCommitWidget);
+               this, &FossilPluginPrivate::commitStatusReady);
 
+    if (CommitEditor *commitEditor = m_prefilledCommitEditor.data()) {
+        m_prefilledCommitEditor.clear();
+        commitEditor->updateFileStatus(status);
+        return;
+    }
+    showCommitWidget(status);
+}
+
+CommitEditor *FossilPluginPrivate::showCommitWidget(const QList<VcsBase::VcsBaseClient::StatusItem> &status)
+{
     if (status.isEmpty()) {
         VcsBase::VcsOutputWindow::appendError(tr("There are no changes to commit."));
-        return;
+        return nullptr;
     }
 
     // Start new temp file for commit message
@@ -724,20 +857,20 @@ void FossilPluginPrivate::showCommitWidget(const QList<VcsBase::VcsBaseClient::S
     saver.setAutoRemove(false);
     if (!saver.finalize()) {
         VcsBase::VcsOutputWindow::appendError(saver.errorString());
-        return;
+        return nullptr;
     }
 
     Core::IEditor *editor = Core::EditorManager::openEditor(saver.fileName(), Constants::COMMIT_ID);
     if (!editor) {
         VcsBase::VcsOutputWindow::appendError(tr("Unable to create an editor for the commit."));
-        return;
+        return nullptr;
     }
 
     CommitEditor *commitEditor = qobject_cast<CommitEditor *>(editor);
 
     if (!commitEditor) {
         VcsBase::VcsOutputWindow::appendError(tr("Unable to create a commit editor."));
-        return;
+        return nullptr;
     }
     setSubmitEditor(commitEditor);
 
@@ -745,17 +878,32 @@ void FossilPluginPrivate::showCommitWidget(const QList<VcsBase::VcsBaseClient::S
             arg(QDir::toNativeSeparators(m_submitRepository));
     commitEditor->document()->setPreferredDisplayName(msg);
 
-    const RevisionInfo currentRevision = m_client.synchronousRevisionQuery(m_submitRepository);
-    const BranchInfo currentBranch = m_client.synchronousCurrentBranch(m_submitRepository);
-    const QString currentUser = m_client.synchronousUserDefaultQuery(m_submitRepository);
-    QStringList tags = m_client.synchronousTagQuery(m_submitRepository, currentRevision.id);
-    // Fossil includes branch name in tag list -- remove.
-    tags.removeAll(currentBranch.name());
-    commitEditor->setFields(m_submitRepository, currentBranch, tags, currentUser, status);
+    // Open the editor right away, fill in the fields as the queries complete.
+    // The editor is the context, so the results are dropped once it's closed.
+    commitEditor->setFieldsPending(m_submitRepository, status);
+    FossilCommitWidget *commitWidget = commitEditor->commitWidget();
+
+    Utils::onResultReady(m_commitQueries.branch, commitWidget, [commitWidget](const BranchInfo &branch) {
+        commitWidget->setCurrentBranch(branch);
+    });
+    Utils::onResultReady(m_commitQueries.user, commitWidget, [commitWidget](const QString &user) {
+        commitWidget->setUserName(user);
+    });
+    // Tags are listed for the current revision, so chain them on its id
+    const QString repository = m_submitRepository;
+    Utils::onResultReady(m_commitQueries.revision, commitWidget,
+                         [this, commitWidget, repository](const RevisionInfo &revision) {
+        Utils::onResultReady(m_client.tagQuery(repository, revision.id), commitWidget,
+                             [commitWidget](const QStringList &tags) {
+            commitWidget->setCurrentTags(tags);
+        });
+    });
+    m_commitQueries = {};
 
     connect(commitEditor, &VcsBase::VcsBaseSubmitEditor::diffSelectedFiles,
             this, &FossilPluginPrivate::diffFromEditorSelected);
     commitEditor->setCheckScriptWorkingDirectory(m_submitRepository);
+    return commitEditor;
 }
 
 void FossilPluginPrivate::diffFromEditorSelected(const QStringList &files)
@@ -770,6 +918,98 @@ static inline bool ask(QWidget *parent, const QString &title, const QString &que
     return QMessageBox::question(parent, title, question, QMessageBox::Yes|QMessageBox::No, defaultButton) == QMessageBox::Yes;
 }
 
+void FossilPluginPrivate::exportTrace()
+{
+    const QString fileName = QFileDialog::getSaveFileName(
+                Core::ICore::dialogParent(), tr("Export Command Trace"),
+                QDir::homePath() + "/fossil-trace.json",
+                tr("Chrome Trace Files (*.json)"));
+    if (fileName.isEmpty())
+        return;
+
+    Utils::FileSaver saver(fileName, QIODevice::Text);
+    saver.write(m_client.tracer().toChromeTrace());
+    QString errorMessage;
+    if (!saver.finalize(&errorMessage)) {
+        VcsBase::VcsOutputWindow::appendError(errorMessage);
+        return;
+    }
+    VcsBase::VcsOutputWindow::appendMessage(tr("Exported %n command trace events to \"%1\".",
+                                               nullptr, m_client.tracer().size())
+                                            .arg(QDir::toNativeSeparators(fileName)));
+}
+
+void FossilPluginPrivate::showAutoPullStatus()
+{
+    const QHash<QString, AutoPullScheduler::Statistics> statistics = m_autoPullScheduler.statistics();
+    if (statistics.isEmpty()) {
+        VcsBase::VcsOutputWindow::appendMessage(tr("No repositories are scheduled for auto-pull."));
+        return;
+    }
+
+    for (auto it = statistics.cbegin(), end = statistics.cend(); it != end; ++it) {
+        const AutoPullScheduler::Statistics &stats = it.value();
+        const QString repository = QDir::toNativeSeparators(it.key());
+        QString message;
+        if (!stats.lastSync.isValid()) {
+            message = tr("%1: not pulled yet").arg(repository);
+        } else {
+            message = tr("%1: pulled at %2 in %3 ms, %4 artifacts, %5 bytes received")
+                    .arg(repository, stats.lastSync.toLocalTime().toString(Qt::DefaultLocaleShortDate))
+                    .arg(stats.lastLatencyMs).arg(stats.lastArtifactsReceived)
+                    .arg(stats.lastBytesReceived);
+        }
+        if (stats.failureCount > 0)
+            message += tr(", %n failed attempt(s) since", nullptr, stats.failureCount);
+        VcsBase::VcsOutputWindow::appendMessage(message);
+    }
+}
+
+void FossilPluginPrivate::statusAllCheckouts()
+{
+    runForAllCheckouts(tr("Fossil Status"), {"changes"}, false);
+}
+
+void FossilPluginPrivate::pullAllCheckouts()
+{
+    // Check-outs sharing a repository file are pulled once
+    runForAllCheckouts(tr("Fossil Pull"), {"pull"}, true, true);
+}
+
+void FossilPluginPrivate::updateAllCheckouts()
+{
+    runForAllCheckouts(tr("Fossil Update"), {"update"}, true);
+}
+
+void FossilPluginPrivate::runForAllCheckouts(const QString &title, const QStringList &args,
+                                             bool expectRepoChanges, bool perRepository)
+{
+    const QStringList topLevels = openCheckouts();
+    if (topLevels.isEmpty()) {
+        VcsBase::VcsOutputWindow::appendWarning(tr("There are no Fossil check-outs in the open projects."));
+        return;
+    }
+
+    VcsBase::VcsOutputWindow::appendMessage(tr("%1: fossil %2 in %n check-out(s)", nullptr,
+                                               topLevels.size()).arg(title, args.join(' ')));
+    auto runner = new MultiCheckoutRunner(&m_client, title, args, topLevels, this);
+    runner->setExpectRepoChanges(expectRepoChanges);
+    runner->setPerRepository(perRepository);
+    runner->start();
+}
+
+QStringList FossilPluginPrivate::openCheckouts() const
+{
+    // Top-levels of the check-outs of the open projects
+    QStringList topLevels;
+    for (const ProjectExplorer::Project *project : ProjectExplorer::SessionManager::projects()) {
+        const QString topLevel = m_client.findTopLevelForFile(project->projectDirectory().toFileInfo());
+        if (!topLevel.isEmpty() && !topLevels.contains(topLevel))
+            topLevels.append(topLevel);
+    }
+    return topLevels;
+}
+
 void FossilPluginPrivate::createRepository()
 {
     // re-implemented from void VcsBasePlugin::createRepository()
@@ -900,6 +1140,9 @@ void FossilPluginPrivate::updateActions(VcsBase::VcsBasePluginPrivate::ActionSta
 
     foreach (QAction *repoAction, m_repositoryActionList)
         repoAction->setEnabled(repoEnabled);
+
+    if (repoEnabled)
+        m_statusModel.watchCheckout(currentState().topLevel());
 }
 
 QString FossilPluginPrivate::displayName() const
@@ -1121,6 +1364,11 @@ Core::ShellCommand *FossilPluginPrivate::createInitialCheckoutCommand(const QStr
         command->addJob({m_client.vcsBinary(), args}, -1);
     }
 
+    // The directories below the new check-out may have been looked up already
+    connect(command, &Core::ShellCommand::finished, this, [this, checkoutPath] {
+        m_client.topLevelCache().invalidate(checkoutPath);
+    });
+
     return command;
 }
 
@@ -1128,9 +1376,15 @@ void FossilPluginPrivate::changed(const QVariant &v)
 {
     switch (v.type()) {
     case QVariant::String:
+        m_statusModel.invalidate(v.toString());
+        m_client.managedFileIndex().invalidate(v.toString());
+        m_client.topLevelCache().clearUnmanaged();
+        m_inlineBlame.refresh();
         emit repositoryChanged(v.toString());
         break;
     case QVariant::StringList:
+        m_statusModel.invalidateFiles(v.toStringList());
+        m_client.managedFileIndex().invalidateFiles(v.toStringList());
         emit filesChanged(v.toStringList());
         break;
     default:
@@ -1142,8 +1396,26 @@ void FossilPluginPrivate::changed(const QVariant &v)
 } // namespace Fossil
 
 #ifdef WITH_TESTS
+#include "outputparser.h"
+#include "revisioncache.h"
+
+#include <QFile>
 #include <QTest>
 
+// Output recorded from a generated repository, when FOSSIL_FIXTURES_DIR is set.
+// See tests/benchmarks/fossil/fixturegen.
+static QByteArray recordedFixtureOutput(const QString &fileName)
+{
+    const QString fixturesDir = qEnvironmentVariable("FOSSIL_FIXTURES_DIR");
+    if (fixturesDir.isEmpty())
+        return QByteArray();
+
+    QFile file(QDir(fixturesDir).absoluteFilePath("small/" + fileName));
+    if (!file.open(QIODevice::ReadOnly))
+        return QByteArray();
+    return file.readAll();
+}
+
 void Fossil::Internal::FossilPlugin::testDiffFileResolving_data()
 {
     QTest::addColumn<QByteArray>("header");
@@ -1175,6 +1447,17 @@ void Fossil::Internal::FossilPlugin::testDiffFileResolving_data()
             "@@ -112,22 +112,37 @@\n"
         )
         << QByteArray("src/plugins/fossil/fossilclient.cpp");
+
+    // First file of a diff recorded from a generated repository
+    const QByteArray diff = recordedFixtureOutput("diff.txt");
+    const int fileStart = diff.indexOf("Index: ");
+    const int chunkStart = diff.indexOf("\n@@ ", fileStart);
+    if (fileStart >= 0 && chunkStart > fileStart) {
+        const int chunkEnd = diff.indexOf('\n', chunkStart + 1);
+        const QByteArray header = diff.mid(fileStart, chunkEnd + 1 - fileStart);
+        const QByteArray fileName = header.mid(7, header.indexOf('\n') - 7).trimmed();
+        QTest::newRow("Recorded") << header << fileName;
+    }
 }
 
 void Fossil::Internal::FossilPlugin::testDiffFileResolving()
@@ -1193,5 +1476,283 @@ void Fossil::Internal::FossilPlugin::testLogResolving()
         "   EDITED src/core/scaler.h\n"
     );
     VcsBase::VcsBaseEditorWidget::testLogResolving(dd->fileLogFactory, data, "ac6d1129b8", "56d6917c3b");
+
+    const QByteArray recorded = recordedFixtureOutput("timeline.txt");
+    if (recorded.isEmpty())
+        return;
+
+    TimelineParser parser;
+    parser.addData(QString::fromUtf8(recorded));
+    parser.finish();
+    const QList<TimelineEntry> entries = parser.takeEntries();
+    QVERIFY(entries.size() >= 2);
+    VcsBase::VcsBaseEditorWidget::testLogResolving(dd->fileLogFactory, recorded,
+                                                   entries.at(0).id.toLatin1(),
+                                                   entries.at(1).id.toLatin1());
+}
+
+void Fossil::Internal::FossilPlugin::testTimelineParsing()
+{
+    const QString data(
+        "=== 2014-03-08 ===\n"
+        "22:14:02 [ac6d1129b8] *CURRENT* Change scaling algorithm. (user: ninja tags: ninja-fixes-5.1)\n"
+        "   EDITED src/core/scaler.cpp\n"
+        "20:23:51 [56d6917c3b] *BRANCH* Add width option (conditional). (user: ninja tags: ninja-fixes-5.1, trunk)\n"
+        "   EDITED src/core/scaler.cpp\n"
+        "   EDITED src/core/scaler.h\n"
+        "=== 2014-03-07 ===\n"
+        "09:01:10 [0c3a4f7e21] Initial import. (user: admin)\n"
+        "+++ no more data (3) +++\n"
+    );
+
+    // Feed the output in chunks split mid-line
+    TimelineParser parser;
+    parser.addData(data.left(40));
+    QVERIFY(parser.takeEntries().isEmpty());
+    parser.addData(data.mid(40, 200));
+    parser.addData(data.mid(240));
+    parser.finish();
+
+    const QList<TimelineEntry> entries = parser.takeEntries();
+    QCOMPARE(entries.size(), 3);
+    QVERIFY(parser.isAtEnd());
+
+    QCOMPARE(entries.at(0).id, QString("ac6d1129b8"));
+    QCOMPARE(entries.at(0).date, QString("2014-03-08"));
+    QCOMPARE(entries.at(0).time, QString("22:14:02"));
+    QCOMPARE(entries.at(0).markers, QStringList("CURRENT"));
+    QCOMPARE(entries.at(0).comment, QString("Change scaling algorithm."));
+    QCOMPARE(entries.at(0).user, QString("ninja"));
+    QCOMPARE(entries.at(0).files, QStringList("EDITED src/core/scaler.cpp"));
+
+    QCOMPARE(entries.at(1).comment, QString("Add width option (conditional)."));
+    QCOMPARE(entries.at(1).tags, QStringList({"ninja-fixes-5.1", "trunk"}));
+    QCOMPARE(entries.at(1).files.size(), 2);
+
+    QCOMPARE(entries.at(2).date, QString("2014-03-07"));
+    QCOMPARE(entries.at(2).user, QString("admin"));
+    QVERIFY(entries.at(2).tags.isEmpty());
+}
+
+void Fossil::Internal::FossilPlugin::testBlameParsing()
+{
+    const QString data(
+        "ac6d1129b8 2014-03-08         ninja: void scale(int width)\n"
+        "0c3a4f7e21 2014-03-07         admin: {\n"
+        "                                    :     // text: with a colon\n"
+    );
+
+    const BlameLines lines = OutputParser::parseBlame(data);
+    QCOMPARE(lines.size(), 3);
+
+    QCOMPARE(lines.at(0).changeId, QString("ac6d1129b8"));
+    QCOMPARE(lines.at(0).date, QDate(2014, 3, 8));
+    QCOMPARE(lines.at(0).user, QString("ninja"));
+    QCOMPARE(lines.at(1).user, QString("admin"));
+    QCOMPARE(lines.at(0).text, QString("void scale(int width)"));
+    QCOMPARE(lines.at(1).text, QString("{"));
+    // past the annotation limit
+    QVERIFY(lines.at(2).changeId.isEmpty());
+    QCOMPARE(lines.at(2).text, QString("    // text: with a colon"));
+}
+
+void Fossil::Internal::FossilPlugin::testStatusParsing()
+{
+    const QByteArray data(
+        "EDITED     src/core/scaler.cpp\n"
+        "ADDED_BY_MERGE src/core/scaler.h\r\n"
+        "NOT_A_FILE src/core\n"
+        "EDITEX     src/core/unknown.cpp\n"
+        "\n"
+        "UPDATED_BY_INTEGRATE doc/with space.txt"
+    );
+
+    const StatusRecords records = OutputParser::parseStatus(data);
+    const auto path = [&data, &records](int i) {
+        return data.mid(records.at(i).pathOffset, records.at(i).pathSize);
+    };
+    QCOMPARE(records.size(), 4);
+    QCOMPARE(records.at(0).status, FileStatus::Edited);
+    QCOMPARE(path(0), QByteArray("src/core/scaler.cpp"));
+    QCOMPARE(records.at(1).status, FileStatus::AddedByMerge);
+    QCOMPARE(path(1), QByteArray("src/core/scaler.h"));
+    QCOMPARE(records.at(2).status, FileStatus::Unknown);
+    QCOMPARE(path(3), QByteArray("doc/with space.txt"));
+
+    // The line parser agrees, sharing the flags
+    const VcsBase::VcsBaseClient::StatusItem item
+            = OutputParser::parseStatusLine("ADDED_BY_MERGE src/core/scaler.h");
+    QCOMPARE(item.file, QString("src/core/scaler.h"));
+    QCOMPARE(item.flags.constData(),
+             OutputParser::statusFlags(FileStatus::AddedByMerge).constData());
+    QCOMPARE(OutputParser::fileStatus(Constants::FSTATUS_ADDED_BY_MERGE), FileStatus::AddedByMerge);
+    QVERIFY(OutputParser::parseStatusLine("EDITEX src/core/unknown.cpp").file.isEmpty());
+}
+
+void Fossil::Internal::FossilPlugin::testRevisionInfoParsing()
+{
+    const QByteArray data(
+        "project-name: Fossil Plugin\n"
+        "repository:   /home/user/fossil plugin.fossil\r\n"
+        "checkout:     7f4f7a0f8dbc2b1c7a3f7dcb0ce8b5e5c6a0e8d1e2f3a4b5c6d7e8f9a0b1c2d3 2020-03-05 14:22:33 UTC\r\n"
+        "parent:       0a1b2c3d4e 2020-03-04 10:01:02 UTC\n"
+        "merged-from:  6e7f8a9b0c 2020-03-03 09:00:00 UTC\n"
+        "merged-from:  1a2b3c4d5e 2020-03-02 09:00:00 UTC\n"
+        "tags:         trunk\n"
+        "comment:      Merge the (user: pending) fixes (user: user1)\n"
+    );
+
+    const RevisionInfo info = OutputParser::parseRevisionInfo(data, true, true);
+    QCOMPARE(info.id, QString("7f4f7a0f8dbc2b1c7a3f7dcb0ce8b5e5c6a0e8d1e2f3a4b5c6d7e8f9a0b1c2d3"));
+    QCOMPARE(info.parentId, QString("0a1b2c3d4e"));
+    QCOMPARE(info.mergeParentIds, QStringList({"6e7f8a9b0c", "1a2b3c4d5e"}));
+    QCOMPARE(info.commentMsg, QString("Merge the (user: pending) fixes"));
+    QCOMPARE(info.committer, QString("user1"));
+    QCOMPARE(OutputParser::parseRepositoryFile(QString::fromUtf8(data)),
+             QString("/home/user/fossil plugin.fossil"));
+
+    // legacy clients, the comment not asked for
+    const RevisionInfo legacyInfo = OutputParser::parseRevisionInfo(
+                "uuid:         ac6d1129b8 2014-03-08 22:14:02 UTC\n"
+                "comment:      Initial import. (user: admin)\n", false, false);
+    QCOMPARE(legacyInfo.id, QString("ac6d1129b8"));
+    QCOMPARE(legacyInfo.parentId, legacyInfo.id);
+    QVERIFY(legacyInfo.commentMsg.isEmpty());
+}
+
+void Fossil::Internal::FossilPlugin::testManifestParsing()
+{
+    const QByteArray manifest(
+        "B 5a0b1c2d3e4f5a6b7c8d9e0f1a2b3c4d5e6f7a8b\n"
+        "C Fix\\sthe\\sscaler\n"
+        "D 2020-03-05T14:22:33.000\n"
+        "F doc/with\\sspace.txt 0f1e2d3c4b5a69788796a5b4c3d2e1f00f1e2d3c\n"
+        "F src/core/scaler.cpp 1a2b3c4d5e6f708192a3b4c5d6e7f8091a2b3c4d x src/scaler.cpp\n"
+        "F src/core/scaler.h\n"
+        "P 0a1b2c3d4e5f60718293a4b5c6d7e8f90a1b2c3d\n"
+        "U user1\n"
+        "Z 0123456789abcdef0123456789abcdef\n"
+    );
+
+    QString baselineId;
+    QCOMPARE(OutputParser::parseManifestFileHash(manifest, "src/core/scaler.cpp", &baselineId),
+             Utils::optional<QString>("1a2b3c4d5e6f708192a3b4c5d6e7f8091a2b3c4d"));
+    QCOMPARE(baselineId, QString("5a0b1c2d3e4f5a6b7c8d9e0f1a2b3c4d5e6f7a8b"));
+    QCOMPARE(OutputParser::parseManifestFileHash(manifest, "doc/with space.txt"),
+             Utils::optional<QString>("0f1e2d3c4b5a69788796a5b4c3d2e1f00f1e2d3c"));
+
+    // deleted in the delta manifest, or not listed at all
+    const Utils::optional<QString> deleted
+            = OutputParser::parseManifestFileHash(manifest, "src/core/scaler.h");
+    QVERIFY(deleted && deleted->isEmpty());
+    QVERIFY(!OutputParser::parseManifestFileHash(manifest, "src/core"));
+}
+
+void Fossil::Internal::FossilPlugin::testSyncProgressParsing()
+{
+    // summary of the older versions, the progress line rewritten after each round-trip
+    const QString oldOutput(
+        "Round-trips: 1   Artifacts sent: 0  received: 0\r"
+        "Round-trips: 2   Artifacts sent: 0  received: 15\r"
+        "Round-trips: 3   Artifacts sent: 2  received: 40\r"
+        "\nPull done, sent: 1126  received: 2890  ip: 10.0.0.1\n"
+    );
+
+    SyncProgress progress;
+    QCOMPARE(OutputParser::parseSyncProgress(oldOutput, &progress), oldOutput.size());
+    QCOMPARE(progress.roundTrips, 3);
+    QCOMPARE(progress.artifactsSent, 2);
+    QCOMPARE(progress.artifactsReceived, 40);
+    QCOMPARE(progress.bytesSent, qint64(1126));
+    QCOMPARE(progress.bytesReceived, qint64(2890));
+    QVERIFY(progress.isDone);
+
+    // summary in wire bytes
+    progress = SyncProgress();
+    OutputParser::parseSyncProgress(
+                "Round-trips: 1   Artifacts sent: 0  received: 7\r"
+                "\nSync done, wire bytes sent: 4096  received: 123456789012  ip: 10.0.0.1\n",
+                &progress);
+    QCOMPARE(progress.roundTrips, 1);
+    QCOMPARE(progress.artifactsReceived, 7);
+    QCOMPARE(progress.bytesSent, qint64(4096));
+    QCOMPARE(progress.bytesReceived, qint64(123456789012));
+    QVERIFY(progress.isDone);
+
+    // in progress
+    progress = SyncProgress();
+    OutputParser::parseSyncProgress(oldOutput.left(oldOutput.indexOf("\nPull")), &progress);
+    QCOMPARE(progress.roundTrips, 3);
+    QVERIFY(!progress.isDone);
+
+    // chunks cut within the lines and the numbers, the rest carried to the next chunk
+    progress = SyncProgress();
+    QString pending;
+    const int cuts[] = {10, 47, 60, 95, 144, 182};
+    int start = 0;
+    for (int cut : cuts) {
+        pending += oldOutput.mid(start, cut - start);
+        start = cut;
+        pending.remove(0, OutputParser::parseSyncProgress(pending, &progress, true));
+        QVERIFY(progress.roundTrips <= 3);
+        QVERIFY(progress.artifactsReceived == 0 || progress.artifactsReceived == 15
+                || progress.artifactsReceived == 40);
+        QVERIFY(progress.bytesReceived == 0 || progress.bytesReceived == 2890);
+    }
+    pending += oldOutput.mid(start);
+    pending.remove(0, OutputParser::parseSyncProgress(pending, &progress, true));
+    QVERIFY(pending.isEmpty());
+    QCOMPARE(progress.roundTrips, 3);
+    QCOMPARE(progress.artifactsReceived, 40);
+    QCOMPARE(progress.bytesReceived, qint64(2890));
+    QVERIFY(progress.isDone);
+}
+
+void Fossil::Internal::FossilPlugin::testRevisionCache()
+{
+    const QString repository1("/home/user/repo1.fossil");
+    const QString repository2("/home/user/repo2.fossil");
+    const QString hash1("ac6d1129b8ac6d1129b8ac6d1129b8ac6d1129b8");
+    const QString hash2("0c3a4f7e210c3a4f7e210c3a4f7e210c3a4f7e21");
+    const QString hash3("5a0b1c2d3e5a0b1c2d3e5a0b1c2d3e5a0b1c2d3e");
+
+    RevisionCache cache(2);
+    cache.insert(repository1, RevisionInfo(hash1, hash2, {}, "Fix the scaler", "ninja"), "ac6d1129b8");
+    QCOMPARE(cache.size(), 1);
+
+    // by the full hash and by the alias, in any case
+    Utils::optional<RevisionInfo> revisionInfo = cache.find(repository1, hash1);
+    QVERIFY(revisionInfo);
+    QCOMPARE(revisionInfo->parentId, hash2);
+    QCOMPARE(revisionInfo->committer, QString("ninja"));
+    QVERIFY(cache.find(repository1, "AC6D1129B8"));
+
+    // a name not a prefix of the hash is no alias, it may move
+    cache.insert(repository1, RevisionInfo(hash1, hash2, {}, "Fix the scaler", "ninja"), "cafe01");
+    QVERIFY(!cache.find(repository1, "cafe01"));
+
+    // a prefix is not matched, nor the entries of another repository
+    QVERIFY(!cache.find(repository1, "ac6d1129"));
+    QVERIFY(!cache.find(repository2, hash1));
+    QVERIFY(!cache.find(repository2, "ac6d1129b8"));
+
+    // the same check-in in another repository is a separate entry
+    cache.insert(repository2, RevisionInfo(hash1, QString(), {}, "Fix the scaler", "admin"));
+    QCOMPARE(cache.find(repository2, hash1)->committer, QString("admin"));
+    QCOMPARE(cache.find(repository1, hash1)->committer, QString("ninja"));
+
+    // the least recently used entry is evicted with its aliases
+    cache.insert(repository1, RevisionInfo(hash3));
+    QCOMPARE(cache.size(), 2);
+    QVERIFY(!cache.find(repository2, hash1));
+    QVERIFY(cache.find(repository1, "ac6d1129b8"));
+    QVERIFY(cache.find(repository1, hash3));
+    cache.insert(repository2, RevisionInfo(hash2));
+    QVERIFY(!cache.find(repository1, hash1));
+    QVERIFY(!cache.find(repository1, "ac6d1129b8"));
+
+    cache.clear();
+    QCOMPARE(cache.size(), 0);
+    QVERIFY(!cache.find(repository1, hash3));
 }
 #endif
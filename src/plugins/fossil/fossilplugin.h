@@ -66,6 +66,13 @@ private slots:
     void testDiffFileResolving_data();
     void testDiffFileResolving();
     void testLogResolving();
+    void testTimelineParsing();
+    void testBlameParsing();
+    void testStatusParsing();
+    void testRevisionInfoParsing();
+    void testManifestParsing();
+    void testSyncProgressParsing();
+    void testRevisionCache();
 #endif
 };
 
@@ -43,6 +43,13 @@ const QString FossilSettings::timelineLineageFilterKey("timelineLineageFilter");
 const QString FossilSettings::timelineVerboseKey("timelineVerbose");
 const QString FossilSettings::timelineItemTypeKey("timelineItemType");
 const QString FossilSettings::disableAutosyncKey("disableAutosync");
+const QString FossilSettings::useDatabaseBackendKey("useDatabaseBackend");
+const QString FossilSettings::inlineBlameKey("inlineBlame");
+const QString FossilSettings::autoPullIntervalKey("autoPullInterval");
+const QString FossilSettings::maxJobsPerCheckoutKey("maxJobsPerCheckout");
+const QString FossilSettings::artifactCacheSizeKey("artifactCacheSize");
+const QString FossilSettings::binaryVersionKey("binaryVersion");
+const QString FossilSettings::binaryFingerprintKey("binaryFingerprint");
 
 FossilSettings::FossilSettings()
 {
@@ -60,6 +67,17 @@ FossilSettings::FossilSettings()
     declareKey(timelineVerboseKey, false);
     declareKey(timelineItemTypeKey, "all");
     declareKey(disableAutosyncKey, true);
+    declareKey(useDatabaseBackendKey, false);
+    declareKey(inlineBlameKey, false);
+    // Minutes between the background pulls, 0 to disable
+    declareKey(autoPullIntervalKey, 0);
+    // Concurrent fossil commands in a check-out, which share its SQLite databases
+    declareKey(maxJobsPerCheckoutKey, 2);
+    // Megabytes of file revisions and diffs kept on disk, 0 to disable
+    declareKey(artifactCacheSizeKey, 256);
+    // Probed version of the binary, identified by its path, size and time-stamp
+    declareKey(binaryVersionKey, 0);
+    declareKey(binaryFingerprintKey, "");
 }
 
 RepositorySettings::RepositorySettings()
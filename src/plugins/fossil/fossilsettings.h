@@ -45,6 +45,13 @@ public:
     static const QString timelineVerboseKey;
     static const QString timelineItemTypeKey;
     static const QString disableAutosyncKey;
+    static const QString useDatabaseBackendKey;
+    static const QString inlineBlameKey;
+    static const QString autoPullIntervalKey;
+    static const QString maxJobsPerCheckoutKey;
+    static const QString artifactCacheSizeKey;
+    static const QString binaryVersionKey;
+    static const QString binaryFingerprintKey;
 
     FossilSettings();
 };
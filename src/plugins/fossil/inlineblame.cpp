@@ -0,0 +1,306 @@
+/**************************************************************************
+**  This file is part of Fossil VCS plugin for Qt Creator
+**
+**  Copyright (c) 2013 - 2020, Artur Shepilko, <qtc-fossil@nomadbyte.com>.
+**
+**  Based on Bazaar VCS plugin for Qt Creator by Hugues Delorme.
+**
+**  Permission is hereby granted, free of charge, to any person obtaining a copy
+**  of this software and associated documentation files (the "Software"), to deal
+**  in the Software without restriction, including without limitation the rights
+**  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+**  copies of the Software, and to permit persons to whom the Software is
+**  furnished to do so, subject to the following conditions:
+**
+**  The above copyright notice and this permission notice shall be included in
+**  all copies or substantial portions of the Software.
+**
+**  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+**  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+**  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+**  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+**  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+**  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+**  THE SOFTWARE.
+**************************************************************************/
+
+
+#include "inlineblame.h"
+#include "fossilclient.h"
+
+#include <coreplugin/editormanager/editormanager.h>
+#include <texteditor/texteditor.h>
+#include <texteditor/textdocument.h>
+#include <texteditor/textmark.h>
+#include <utils/qtcassert.h>
+#include <utils/runextensions.h>
+
+#include <QFileInfo>
+#include <QStringList>
+#include <QTextBlock>
+#include <QTextDocument>
+
+namespace Fossil {
+namespace Internal {
+
+const char INLINE_BLAME_CATEGORY[] = "Fossil.InlineBlame";
+const int shortChangesetIdSize = 10;
+// Largest table of the line alignment, the lines past it are left unattributed
+const qint64 maxAlignmentCells = 4 * 1024 * 1024;
+
+InlineBlame::InlineBlame(FossilClient *client, QObject *parent) : QObject(parent),
+    m_client(client)
+{
+    QTC_CHECK(m_client);
+
+    connect(Core::EditorManager::instance(), &Core::EditorManager::currentEditorChanged,
+            this, &InlineBlame::currentEditorChanged);
+}
+
+InlineBlame::~InlineBlame() = default;
+
+void InlineBlame::setEnabled(bool enabled)
+{
+    if (m_enabled == enabled)
+        return;
+    m_enabled = enabled;
+
+    if (!m_enabled) {
+        for (auto it = m_documents.cbegin(), end = m_documents.cend(); it != end; ++it) {
+            disconnect(it.key()->document(), nullptr, this, nullptr);
+            disconnect(it.key(), nullptr, this, nullptr);
+        }
+        m_documents.clear();
+    }
+    currentEditorChanged(Core::EditorManager::currentEditor());
+}
+
+bool InlineBlame::isEnabled() const
+{
+    return m_enabled;
+}
+
+void InlineBlame::refresh()
+{
+    for (auto it = m_documents.begin(), end = m_documents.end(); it != end; ++it) {
+        it->lines.reset();
+        requestBlame(it.key());
+    }
+    updateMark();
+}
+
+void InlineBlame::currentEditorChanged(Core::IEditor *editor)
+{
+    m_mark.reset();
+    if (m_editorWidget)
+        disconnect(m_editorWidget, nullptr, this, nullptr);
+    m_editorWidget.clear();
+
+    auto textEditor = qobject_cast<TextEditor::BaseTextEditor *>(editor);
+    if (!m_enabled || !textEditor)
+        return;
+
+    // Only the files of the check-outs, this also skips the VCS output editors
+    TextEditor::TextDocument *document = textEditor->textDocument();
+    const QFileInfo fileInfo = document->filePath().toFileInfo();
+    if (!fileInfo.isFile() || !m_client->managesFile(fileInfo.absolutePath(), fileInfo.fileName()))
+        return;
+
+    m_editorWidget = textEditor->editorWidget();
+    connect(m_editorWidget, &QPlainTextEdit::cursorPositionChanged, this, &InlineBlame::updateMark);
+
+    if (!m_documents.contains(document)) {
+        m_documents.insert(document, DocumentBlame());
+        connect(document->document(), &QTextDocument::contentsChange,
+                this, [this, document](int position, int charsRemoved, int charsAdded) {
+            contentsChanged(document, position, charsRemoved, charsAdded);
+        });
+        connect(document, &QObject::destroyed, this, [this, document] {
+            m_documents.remove(document);
+        });
+        requestBlame(document);
+    }
+    updateMark();
+}
+
+void InlineBlame::requestBlame(TextEditor::TextDocument *document)
+{
+    DocumentBlame &blame = m_documents[document];
+    if (blame.pending)
+        return;
+    blame.pending = true;
+
+    const QFuture<QSharedPointer<const BlameLines>> future
+            = m_client->blameQuery(document->filePath().toString());
+    Utils::onResultReady(future, document,
+                         [this, document](const QSharedPointer<const BlameLines> &lines) {
+        auto it = m_documents.find(document);
+        if (it == m_documents.end())
+            return;
+
+        // The blame is of the check-out version, the document may hold uncommitted
+        // edits. Its lines are aligned to the annotated text, later edits shift the mapping.
+        QTextDocument *textDocument = document->document();
+        it->pending = false;
+        it->lines = lines;
+        it->lineCount = textDocument->blockCount();
+        it->revision = textDocument->revision();
+        it->lineMap = lines ? alignLines(textDocument, *lines) : QVector<int>(it->lineCount, -1);
+
+        if (m_editorWidget && m_editorWidget->textDocument() == document)
+            updateMark();
+    });
+}
+
+void InlineBlame::contentsChanged(TextEditor::TextDocument *document, int position,
+                                  int charsRemoved, int charsAdded)
+{
+    Q_UNUSED(charsRemoved)
+
+    auto it = m_documents.find(document);
+    if (it == m_documents.end() || !it->lines)
+        return;
+
+    // Re-layouts and format changes are reported too, those keep the revision
+    QTextDocument *textDocument = document->document();
+    if (textDocument->revision() == it->revision)
+        return;
+    it->revision = textDocument->revision();
+
+    // Replace the lines touched by the edit with the lines inserted,
+    // which are no longer attributed to a check-in.
+    const int lineCount = textDocument->blockCount();
+    const int firstLine = textDocument->findBlock(position).blockNumber();
+    const int endPosition = qMin(position + charsAdded, textDocument->characterCount() - 1);
+    const int lastNewLine = textDocument->findBlock(endPosition).blockNumber();
+    const int lastOldLine = lastNewLine - (lineCount - it->lineCount);
+
+    if (firstLine < 0 || lastOldLine < firstLine || lastOldLine >= it->lineMap.size()) {
+        // Out of sync, blame the whole document again
+        it->lines.reset();
+        requestBlame(document);
+        return;
+    }
+
+    it->lineMap.remove(firstLine, lastOldLine - firstLine + 1);
+    it->lineMap.insert(firstLine, lastNewLine - firstLine + 1, -1);
+    it->lineCount = lineCount;
+    QTC_CHECK(it->lineMap.size() == it->lineCount);
+
+    if (m_editorWidget && m_editorWidget->textDocument() == document)
+        updateMark();
+}
+
+void InlineBlame::updateMark()
+{
+    if (!m_enabled || !m_editorWidget) {
+        m_mark.reset();
+        return;
+    }
+
+    TextEditor::TextDocument *document = m_editorWidget->textDocument();
+    const auto it = m_documents.constFind(document);
+    const int line = m_editorWidget->textCursor().blockNumber();
+    const QString text = it != m_documents.constEnd() ? lineAnnotation(*it, line) : QString();
+    if (text.isEmpty()) {
+        m_mark.reset();
+        return;
+    }
+
+    // Moving within the line keeps the mark
+    if (m_mark && m_mark->lineNumber() == line + 1 && m_mark->fileName() == document->filePath()
+            && m_mark->lineAnnotation() == text) {
+        return;
+    }
+
+    m_mark.reset(new TextEditor::TextMark(document->filePath(), line + 1,
+                                          Core::Id(INLINE_BLAME_CATEGORY)));
+    m_mark->setLineAnnotation(text);
+}
+
+QVector<int> InlineBlame::alignLines(const QTextDocument *document, const BlameLines &lines)
+{
+    // Longest common subsequence of the lines, past the common head and tail
+    QStringList documentLines;
+    documentLines.reserve(document->blockCount());
+    for (QTextBlock block = document->firstBlock(); block.isValid(); block = block.next())
+        documentLines.append(block.text());
+
+    const int blameCount = lines.size();
+    const int lineCount = documentLines.size();
+    QVector<int> lineMap(lineCount, -1);
+
+    int head = 0;
+    while (head < lineCount && head < blameCount && documentLines.at(head) == lines.at(head).text) {
+        lineMap[head] = head;
+        ++head;
+    }
+    int tail = 0;
+    while (tail < lineCount - head && tail < blameCount - head
+           && documentLines.at(lineCount - 1 - tail) == lines.at(blameCount - 1 - tail).text) {
+        lineMap[lineCount - 1 - tail] = blameCount - 1 - tail;
+        ++tail;
+    }
+
+    const int rows = lineCount - head - tail;
+    const int columns = blameCount - head - tail;
+    if (rows == 0 || columns == 0 || qint64(rows + 1) * (columns + 1) > maxAlignmentCells)
+        return lineMap;
+
+    // lengths[r][c]: common lines of the document lines from r and the blame lines from c
+    QVector<int> lengths((rows + 1) * (columns + 1), 0);
+    const auto length = [&lengths, columns](int r, int c) -> int & {
+        return lengths[r * (columns + 1) + c];
+    };
+    for (int r = rows - 1; r >= 0; --r) {
+        for (int c = columns - 1; c >= 0; --c) {
+            length(r, c) = documentLines.at(head + r) == lines.at(head + c).text
+                    ? length(r + 1, c + 1) + 1
+                    : qMax(length(r + 1, c), length(r, c + 1));
+        }
+    }
+    for (int r = 0, c = 0; r < rows && c < columns; ) {
+        if (documentLines.at(head + r) == lines.at(head + c).text) {
+            lineMap[head + r] = head + c;
+            ++r;
+            ++c;
+        } else if (length(r + 1, c) >= length(r, c + 1)) {
+            ++r;
+        } else {
+            ++c;
+        }
+    }
+    return lineMap;
+}
+
+QString InlineBlame::lineAnnotation(const DocumentBlame &blame, int line) const
+{
+    if (!blame.lines || line < 0 || line >= blame.lineMap.size())
+        return QString();
+
+    const int index = blame.lineMap.at(line);
+    if (index < 0)
+        return tr("Not committed yet");
+
+    const BlameLine &blameLine = blame.lines->at(index);
+    if (blameLine.changeId.isEmpty())
+        return QString();
+
+    return tr("%1 %2, %3").arg(blameLine.changeId.left(shortChangesetIdSize),
+                               blameLine.user, ageText(blameLine.date));
+}
+
+QString InlineBlame::ageText(const QDate &date)
+{
+    const qint64 days = date.daysTo(QDate::currentDate());
+    if (days < 1)
+        return tr("today");
+    if (days < 31)
+        return tr("%n day(s) ago", nullptr, int(days));
+    if (days < 365)
+        return tr("%n month(s) ago", nullptr, int(days / 30));
+    return tr("%n year(s) ago", nullptr, int(days / 365));
+}
+
+} // namespace Internal
+} // namespace Fossil
@@ -0,0 +1,100 @@
+/**************************************************************************
+**  This file is part of Fossil VCS plugin for Qt Creator
+**
+**  Copyright (c) 2013 - 2020, Artur Shepilko, <qtc-fossil@nomadbyte.com>.
+**
+**  Based on Bazaar VCS plugin for Qt Creator by Hugues Delorme.
+**
+**  Permission is hereby granted, free of charge, to any person obtaining a copy
+**  of this software and associated documentation files (the "Software"), to deal
+**  in the Software without restriction, including without limitation the rights
+**  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+**  copies of the Software, and to permit persons to whom the Software is
+**  furnished to do so, subject to the following conditions:
+**
+**  The above copyright notice and this permission notice shall be included in
+**  all copies or substantial portions of the Software.
+**
+**  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+**  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+**  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+**  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+**  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+**  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+**  THE SOFTWARE.
+**************************************************************************/
+
+
+#pragma once
+
+#include "annotationcache.h"
+
+#include <QHash>
+#include <QObject>
+#include <QPointer>
+#include <QSharedPointer>
+#include <QVector>
+
+#include <memory>
+
+QT_BEGIN_NAMESPACE
+class QTextDocument;
+QT_END_NAMESPACE
+
+namespace Core { class IEditor; }
+namespace TextEditor {
+class TextDocument;
+class TextEditorWidget;
+class TextMark;
+}
+
+namespace Fossil {
+namespace Internal {
+
+class FossilClient;
+
+// Shows the blame of the current line at its end in the text editors.
+// The blame of a file is queried once in the background and the lines
+// are kept mapped to it while the document is edited.
+
+class InlineBlame : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit InlineBlame(FossilClient *client, QObject *parent = nullptr);
+    ~InlineBlame() override;
+
+    void setEnabled(bool enabled);
+    bool isEnabled() const;
+
+    // Query the blame again, the check-out revision may have changed
+    void refresh();
+
+private:
+    struct DocumentBlame {
+        QSharedPointer<const BlameLines> lines;
+        QVector<int> lineMap; // document line -> blame line, -1 for the edited lines
+        int lineCount = 0;
+        int revision = 0;     // of the document, as of the last mapping
+        bool pending = false;
+    };
+
+    void currentEditorChanged(Core::IEditor *editor);
+    void requestBlame(TextEditor::TextDocument *document);
+    void contentsChanged(TextEditor::TextDocument *document, int position,
+                         int charsRemoved, int charsAdded);
+    void updateMark();
+    static QVector<int> alignLines(const QTextDocument *document, const BlameLines &lines);
+    QString lineAnnotation(const DocumentBlame &blame, int line) const;
+    static QString ageText(const QDate &date);
+
+    FossilClient *m_client;
+    bool m_enabled = false;
+    QPointer<TextEditor::TextEditorWidget> m_editorWidget;
+    QHash<TextEditor::TextDocument *, DocumentBlame> m_documents;
+    std::unique_ptr<TextEditor::TextMark> m_mark;
+};
+
+} // namespace Internal
+} // namespace Fossil
@@ -0,0 +1,191 @@
+/**************************************************************************
+**  This file is part of Fossil VCS plugin for Qt Creator
+**
+**  Copyright (c) 2013 - 2020, Artur Shepilko, <qtc-fossil@nomadbyte.com>.
+**
+**  Based on Bazaar VCS plugin for Qt Creator by Hugues Delorme.
+**
+**  Permission is hereby granted, free of charge, to any person obtaining a copy
+**  of this software and associated documentation files (the "Software"), to deal
+**  in the Software without restriction, including without limitation the rights
+**  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+**  copies of the Software, and to permit persons to whom the Software is
+**  furnished to do so, subject to the following conditions:
+**
+**  The above copyright notice and this permission notice shall be included in
+**  all copies or substantial portions of the Software.
+**
+**  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+**  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+**  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+**  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+**  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+**  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+**  THE SOFTWARE.
+**************************************************************************/
+
+
+#include "jobscheduler.h"
+
+#include <utils/qtcassert.h>
+#include <vcsbase/vcscommand.h>
+
+#include <QThread>
+
+namespace Fossil {
+namespace Internal {
+
+JobScheduler::JobScheduler(QObject *parent) : QObject(parent),
+    m_maxJobs(qBound(2, QThread::idealThreadCount(), 8))
+{
+}
+
+JobScheduler::~JobScheduler()
+{
+    // Never started commands are not deleted by themselves
+    for (const QList<Job> &jobs : m_pending) {
+        for (const Job &job : jobs)
+            delete job.command.data();
+    }
+}
+
+void JobScheduler::setMaxJobsPerCheckout(int maxJobs)
+{
+    m_maxJobsPerCheckout = qMax(1, maxJobs);
+    dispatch();
+}
+
+void JobScheduler::schedule(VcsBase::VcsCommand *cmd, Priority priority, const QString &checkout,
+                            const QObject *owner, const StartFunction &start)
+{
+    QTC_ASSERT(cmd && start, return);
+    QTC_ASSERT(priority >= 0 && priority < PriorityCount, priority = Interactive);
+
+    if (owner) {
+        cancel(owner);
+        watchOwner(owner);
+    }
+
+    Job job;
+    job.command = cmd;
+    job.checkout = checkout;
+    job.owner = owner;
+    job.start = start;
+    m_pending[priority].append(job);
+    dispatch();
+}
+
+void JobScheduler::cancel(const QObject *owner)
+{
+    if (!owner)
+        return;
+
+    for (QList<Job> &jobs : m_pending) {
+        for (auto it = jobs.begin(); it != jobs.end(); ) {
+            if (it->owner == owner) {
+                if (it->command)
+                    it->command->deleteLater();
+                it = jobs.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    // The canceled command keeps its slot until it is done, but the owner
+    // doesn't get any of its output anymore
+    for (Job &job : m_running) {
+        if (job.owner != owner)
+            continue;
+        job.owner = nullptr;
+        if (job.command) {
+            disconnect(job.command.data(), nullptr, owner, nullptr);
+            job.command->cancel();
+        }
+    }
+}
+
+int JobScheduler::pendingCount() const
+{
+    int count = 0;
+    for (const QList<Job> &jobs : m_pending)
+        count += jobs.size();
+    return count;
+}
+
+int JobScheduler::runningCount() const
+{
+    return m_running.size();
+}
+
+void JobScheduler::dispatch()
+{
+    for (int priority = Interactive; priority < PriorityCount; ++priority) {
+        QList<Job> &jobs = m_pending[priority];
+        for (auto it = jobs.begin(); it != jobs.end(); ) {
+            if (!it->command) {
+                it = jobs.erase(it);
+            } else if (canStart(*it, Priority(priority))) {
+                const Job job = *it;
+                it = jobs.erase(it);
+                start(job);
+            } else {
+                ++it;
+            }
+        }
+    }
+}
+
+bool JobScheduler::canStart(const Job &job, Priority priority) const
+{
+    int maxJobs = m_maxJobs;
+    int maxJobsPerCheckout = m_maxJobsPerCheckout;
+    // Leave a slot for the interactive commands, when there is more than one
+    if (priority != Interactive) {
+        maxJobs = qMax(1, maxJobs - 1);
+        maxJobsPerCheckout = qMax(1, maxJobsPerCheckout - 1);
+    }
+
+    return m_running.size() < maxJobs
+            && m_runningInCheckout.value(job.checkout) < maxJobsPerCheckout;
+}
+
+void JobScheduler::start(const Job &job)
+{
+    VcsBase::VcsCommand *cmd = job.command.data();
+    m_running.insert(cmd, job);
+    ++m_runningInCheckout[job.checkout];
+
+    // The command deletes itself once done, also when canceled
+    connect(cmd, &QObject::destroyed, this, [this](QObject *command) { jobDone(command); });
+    job.start(cmd);
+}
+
+void JobScheduler::jobDone(const QObject *command)
+{
+    const auto it = m_running.find(command);
+    if (it == m_running.end())
+        return;
+
+    const QString checkout = it->checkout;
+    m_running.erase(it);
+    if (--m_runningInCheckout[checkout] <= 0)
+        m_runningInCheckout.remove(checkout);
+
+    dispatch();
+}
+
+void JobScheduler::watchOwner(const QObject *owner)
+{
+    if (m_watchedOwners.contains(owner))
+        return;
+
+    m_watchedOwners.insert(owner);
+    connect(owner, &QObject::destroyed, this, [this, owner] {
+        m_watchedOwners.remove(owner);
+        cancel(owner);
+    });
+}
+
+} // namespace Internal
+} // namespace Fossil
@@ -0,0 +1,100 @@
+/**************************************************************************
+**  This file is part of Fossil VCS plugin for Qt Creator
+**
+**  Copyright (c) 2013 - 2020, Artur Shepilko, <qtc-fossil@nomadbyte.com>.
+**
+**  Based on Bazaar VCS plugin for Qt Creator by Hugues Delorme.
+**
+**  Permission is hereby granted, free of charge, to any person obtaining a copy
+**  of this software and associated documentation files (the "Software"), to deal
+**  in the Software without restriction, including without limitation the rights
+**  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+**  copies of the Software, and to permit persons to whom the Software is
+**  furnished to do so, subject to the following conditions:
+**
+**  The above copyright notice and this permission notice shall be included in
+**  all copies or substantial portions of the Software.
+**
+**  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+**  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+**  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+**  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+**  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+**  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+**  THE SOFTWARE.
+**************************************************************************/
+
+
+#pragma once
+
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QPointer>
+#include <QSet>
+
+#include <functional>
+
+namespace VcsBase { class VcsCommand; }
+
+namespace Fossil {
+namespace Internal {
+
+// Starts the asynchronous fossil commands in the order of their priority,
+// bounding the number of the commands run at the same time, overall and in
+// each check-out, which share its SQLite databases. A command scheduled for
+// an owner, such as an editor, supersedes the owner's earlier command:
+// it is dropped while waiting or canceled while running.
+
+class JobScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Priority {
+        Interactive,        // requested by the user and waited for
+        BackgroundRefresh,  // updates of the already shown data
+        Bulk,               // long transfers, such as pull and push
+        PriorityCount
+    };
+
+    using StartFunction = std::function<void(VcsBase::VcsCommand *)>;
+
+    explicit JobScheduler(QObject *parent = nullptr);
+    ~JobScheduler() override;
+
+    void setMaxJobsPerCheckout(int maxJobs);
+
+    // The start function is called once a slot is free and is expected to execute
+    // the command; the slot is taken until the command deletes itself when done.
+    void schedule(VcsBase::VcsCommand *cmd, Priority priority, const QString &checkout,
+                  const QObject *owner, const StartFunction &start);
+    void cancel(const QObject *owner);
+
+    int pendingCount() const;
+    int runningCount() const;
+
+private:
+    struct Job {
+        QPointer<VcsBase::VcsCommand> command;
+        QString checkout;
+        const QObject *owner = nullptr;
+        StartFunction start;
+    };
+
+    void dispatch();
+    bool canStart(const Job &job, Priority priority) const;
+    void start(const Job &job);
+    void jobDone(const QObject *command);
+    void watchOwner(const QObject *owner);
+
+    QList<Job> m_pending[PriorityCount];
+    QHash<const QObject *, Job> m_running;  // keyed by the command
+    QHash<QString, int> m_runningInCheckout;
+    QSet<const QObject *> m_watchedOwners;
+    int m_maxJobs;
+    int m_maxJobsPerCheckout = 2;
+};
+
+} // namespace Internal
+} // namespace Fossil
@@ -0,0 +1,50 @@
+/**************************************************************************
+**  This file is part of Fossil VCS plugin for Qt Creator
+**
+**  Copyright (c) 2013 - 2020, Artur Shepilko, <qtc-fossil@nomadbyte.com>.
+**
+**  Based on Bazaar VCS plugin for Qt Creator by Hugues Delorme.
+**
+**  Permission is hereby granted, free of charge, to any person obtaining a copy
+**  of this software and associated documentation files (the "Software"), to deal
+**  in the Software without restriction, including without limitation the rights
+**  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+**  copies of the Software, and to permit persons to whom the Software is
+**  furnished to do so, subject to the following conditions:
+**
+**  The above copyright notice and this permission notice shall be included in
+**  all copies or substantial portions of the Software.
+**
+**  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+**  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+**  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+**  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+**  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+**  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+**  THE SOFTWARE.
+**************************************************************************/
+
+
+#include "loghighlighter.h"
+
+namespace Fossil {
+namespace Internal {
+
+FossilLogHighlighter::FossilLogHighlighter(QTextDocument * parent) :
+    QSyntaxHighlighter(parent)
+{
+    m_revisionIdFormat.setForeground(Qt::darkBlue);
+    m_dateFormat.setForeground(Qt::darkBlue);
+    m_dateFormat.setFontWeight(QFont::DemiBold);
+}
+
+void FossilLogHighlighter::highlightBlock(const QString &text)
+{
+    // Match the revision-ids and dates -- highlight them for convenience.
+    LogScanner::scan(text, [this](LogScanner::TokenKind kind, int start, int length) {
+        setFormat(start, length, kind == LogScanner::Date ? m_dateFormat : m_revisionIdFormat);
+    });
+}
+
+} // namespace Internal
+} // namespace Fossil
@@ -0,0 +1,123 @@
+/**************************************************************************
+**  This file is part of Fossil VCS plugin for Qt Creator
+**
+**  Copyright (c) 2013 - 2020, Artur Shepilko, <qtc-fossil@nomadbyte.com>.
+**
+**  Based on Bazaar VCS plugin for Qt Creator by Hugues Delorme.
+**
+**  Permission is hereby granted, free of charge, to any person obtaining a copy
+**  of this software and associated documentation files (the "Software"), to deal
+**  in the Software without restriction, including without limitation the rights
+**  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+**  copies of the Software, and to permit persons to whom the Software is
+**  furnished to do so, subject to the following conditions:
+**
+**  The above copyright notice and this permission notice shall be included in
+**  all copies or substantial portions of the Software.
+**
+**  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+**  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+**  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+**  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+**  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+**  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+**  THE SOFTWARE.
+**************************************************************************/
+
+
+#pragma once
+
+#include <QString>
+#include <QSyntaxHighlighter>
+#include <QTextCharFormat>
+
+namespace Fossil {
+namespace Internal {
+
+// Finds the revision ids and the dates in a line of the log, in a single
+// pass without allocations. Stateless, safe to use from any thread.
+//
+// A revision id is a whole word of 5 to 64 lower-case hex digits, holding at
+// least one decimal digit, so that words such as "added" are not taken for one.
+// A date is "yyyy-mm-dd".
+
+class LogScanner
+{
+public:
+    enum TokenKind { RevisionId, Date };
+
+    // Calls the function with (kind, start, length) for each token found
+    template <typename Function>
+    static void scan(const QString &text, const Function &function);
+
+private:
+    static bool isWordChar(ushort c)
+    {
+        return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')
+                || c == '_' || c > 0x7f;
+    }
+    static bool isDigit(ushort c) { return c >= '0' && c <= '9'; }
+    static bool isDate(const ushort *text, int pos, int size);
+};
+
+template <typename Function>
+void LogScanner::scan(const QString &text, const Function &function)
+{
+    const ushort *data = text.utf16();
+    const int size = text.size();
+
+    int pos = 0;
+    while (pos < size) {
+        if (!isWordChar(data[pos])) {
+            ++pos;
+            continue;
+        }
+
+        int wordEnd = pos;
+        bool isHex = true;
+        bool hasDigit = false;
+        for (; wordEnd < size && isWordChar(data[wordEnd]); ++wordEnd) {
+            const ushort c = data[wordEnd];
+            if (isDigit(c))
+                hasDigit = true;
+            else if (c < 'a' || c > 'f')
+                isHex = false;
+        }
+
+        const int wordSize = wordEnd - pos;
+        if (wordSize == 4 && hasDigit && isDate(data, pos, size)) {
+            function(Date, pos, 10);
+            wordEnd = pos + 10;
+        } else if (isHex && hasDigit && wordSize >= 5 && wordSize <= 64) {
+            function(RevisionId, pos, wordSize);
+        }
+        pos = wordEnd;
+    }
+}
+
+inline bool LogScanner::isDate(const ushort *text, int pos, int size)
+{
+    // "yyyy-mm-dd", the year being checked by the caller
+    return pos + 10 <= size
+            && isDigit(text[pos]) && isDigit(text[pos + 1])
+            && isDigit(text[pos + 2]) && isDigit(text[pos + 3])
+            && text[pos + 4] == '-' && isDigit(text[pos + 5]) && isDigit(text[pos + 6])
+            && text[pos + 7] == '-' && isDigit(text[pos + 8]) && isDigit(text[pos + 9])
+            && (pos + 10 == size || !isWordChar(text[pos + 10]));
+}
+
+class FossilLogHighlighter : public QSyntaxHighlighter
+{
+public:
+    explicit FossilLogHighlighter(QTextDocument *parent);
+
+protected:
+    void highlightBlock(const QString &text) final;
+
+private:
+    QTextCharFormat m_revisionIdFormat;
+    QTextCharFormat m_dateFormat;
+};
+
+} // namespace Internal
+} // namespace Fossil
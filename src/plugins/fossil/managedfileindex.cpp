@@ -0,0 +1,108 @@
+/**************************************************************************
+**  This file is part of Fossil VCS plugin for Qt Creator
+**
+**  Copyright (c) 2013 - 2020, Artur Shepilko, <qtc-fossil@nomadbyte.com>.
+**
+**  Based on Bazaar VCS plugin for Qt Creator by Hugues Delorme.
+**
+**  Permission is hereby granted, free of charge, to any person obtaining a copy
+**  of this software and associated documentation files (the "Software"), to deal
+**  in the Software without restriction, including without limitation the rights
+**  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+**  copies of the Software, and to permit persons to whom the Software is
+**  furnished to do so, subject to the following conditions:
+**
+**  The above copyright notice and this permission notice shall be included in
+**  all copies or substantial portions of the Software.
+**
+**  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+**  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+**  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+**  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+**  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+**  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+**  THE SOFTWARE.
+**************************************************************************/
+
+
+#include "managedfileindex.h"
+#include "constants.h"
+
+#include <utils/hostosinfo.h>
+
+#include <QFileInfo>
+
+#include <algorithm>
+
+namespace Fossil {
+namespace Internal {
+
+ManagedFileIndex::ManagedFileIndex() :
+    m_caseSensitivity(Utils::HostOsInfo::fileNameCaseSensitivity())
+{ }
+
+Utils::optional<bool> ManagedFileIndex::contains(const QString &topLevel,
+                                                 const QString &relativePath) const
+{
+    const QDateTime modified = databaseModified(topLevel);
+
+    QMutexLocker locker(&m_mutex);
+    const auto it = m_entries.constFind(topLevel);
+    if (it == m_entries.constEnd() || it->databaseModified != modified)
+        return Utils::nullopt;
+
+    return it->paths.contains(key(relativePath));
+}
+
+void ManagedFileIndex::insert(const QString &topLevel, const QStringList &relativePaths,
+                              const QDateTime &databaseModified)
+{
+    Entry entry;
+    entry.databaseModified = databaseModified;
+    entry.paths.reserve(relativePaths.size());
+    for (const QString &path : relativePaths)
+        entry.paths.insert(key(path));
+
+    QMutexLocker locker(&m_mutex);
+    m_entries.insert(topLevel, entry);
+}
+
+void ManagedFileIndex::invalidate(const QString &topLevel)
+{
+    QMutexLocker locker(&m_mutex);
+    m_entries.remove(topLevel);
+}
+
+void ManagedFileIndex::invalidateFiles(const QStringList &files)
+{
+    QMutexLocker locker(&m_mutex);
+    for (auto it = m_entries.begin(); it != m_entries.end(); ) {
+        const QString prefix = it.key() + '/';
+        const bool affected = std::any_of(files.cbegin(), files.cend(), [&prefix](const QString &file) {
+            return file.startsWith(prefix);
+        });
+        if (affected)
+            it = m_entries.erase(it);
+        else
+            ++it;
+    }
+}
+
+void ManagedFileIndex::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_entries.clear();
+}
+
+QDateTime ManagedFileIndex::databaseModified(const QString &topLevel)
+{
+    return QFileInfo(topLevel + '/' + Constants::FOSSILREPO).lastModified();
+}
+
+QString ManagedFileIndex::key(const QString &path) const
+{
+    return m_caseSensitivity == Qt::CaseSensitive ? path : path.toLower();
+}
+
+} // namespace Internal
+} // namespace Fossil
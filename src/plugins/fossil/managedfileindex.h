@@ -0,0 +1,75 @@
+/**************************************************************************
+**  This file is part of Fossil VCS plugin for Qt Creator
+**
+**  Copyright (c) 2013 - 2020, Artur Shepilko, <qtc-fossil@nomadbyte.com>.
+**
+**  Based on Bazaar VCS plugin for Qt Creator by Hugues Delorme.
+**
+**  Permission is hereby granted, free of charge, to any person obtaining a copy
+**  of this software and associated documentation files (the "Software"), to deal
+**  in the Software without restriction, including without limitation the rights
+**  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+**  copies of the Software, and to permit persons to whom the Software is
+**  furnished to do so, subject to the following conditions:
+**
+**  The above copyright notice and this permission notice shall be included in
+**  all copies or substantial portions of the Software.
+**
+**  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+**  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+**  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+**  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+**  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+**  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+**  THE SOFTWARE.
+**************************************************************************/
+
+
+#pragma once
+
+#include <utils/optional.h>
+
+#include <QDateTime>
+#include <QHash>
+#include <QMutex>
+#include <QSet>
+#include <QStringList>
+
+namespace Fossil {
+namespace Internal {
+
+// Per-checkout set of the managed files, keyed by the path relative to the top-level.
+// An index is dropped once the check-out database is modified after it was built,
+// or when the plugin is notified of the changes made by its own commands.
+// Thread-safe, lookups may come from the query pool.
+
+class ManagedFileIndex
+{
+public:
+    ManagedFileIndex();
+
+    // No value when there is no current index for the check-out
+    Utils::optional<bool> contains(const QString &topLevel, const QString &relativePath) const;
+    void insert(const QString &topLevel, const QStringList &relativePaths,
+                const QDateTime &databaseModified);
+    void invalidate(const QString &topLevel);
+    void invalidateFiles(const QStringList &files);
+    void clear();
+
+    static QDateTime databaseModified(const QString &topLevel);
+
+private:
+    struct Entry {
+        QSet<QString> paths;
+        QDateTime databaseModified;
+    };
+
+    QString key(const QString &path) const;
+
+    const Qt::CaseSensitivity m_caseSensitivity;
+    mutable QMutex m_mutex;
+    QHash<QString, Entry> m_entries;
+};
+
+} // namespace Internal
+} // namespace Fossil
@@ -0,0 +1,192 @@
+/**************************************************************************
+**  This file is part of Fossil VCS plugin for Qt Creator
+**
+**  Copyright (c) 2013 - 2020, Artur Shepilko, <qtc-fossil@nomadbyte.com>.
+**
+**  Based on Bazaar VCS plugin for Qt Creator by Hugues Delorme.
+**
+**  Permission is hereby granted, free of charge, to any person obtaining a copy
+**  of this software and associated documentation files (the "Software"), to deal
+**  in the Software without restriction, including without limitation the rights
+**  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+**  copies of the Software, and to permit persons to whom the Software is
+**  furnished to do so, subject to the following conditions:
+**
+**  The above copyright notice and this permission notice shall be included in
+**  all copies or substantial portions of the Software.
+**
+**  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+**  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+**  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+**  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+**  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+**  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+**  THE SOFTWARE.
+**************************************************************************/
+
+
+#include "multicheckoutrunner.h"
+#include "fossilclient.h"
+
+#include <coreplugin/progressmanager/progressmanager.h>
+#include <utils/qtcassert.h>
+#include <vcsbase/vcscommand.h>
+#include <vcsbase/vcsoutputwindow.h>
+
+#include <QDir>
+#include <QHash>
+#include <QSharedPointer>
+
+namespace Fossil {
+namespace Internal {
+
+MultiCheckoutRunner::MultiCheckoutRunner(FossilClient *client, const QString &title,
+                                         const QStringList &args, const QStringList &topLevels,
+                                         QObject *parent) : QObject(parent),
+    m_client(client),
+    m_title(title),
+    m_args(args),
+    m_topLevels(topLevels)
+{
+    QTC_CHECK(m_client);
+    QTC_CHECK(!m_args.isEmpty());
+
+    connect(&m_progressWatcher, &QFutureWatcherBase::canceled,
+            this, &MultiCheckoutRunner::cancelTargets);
+}
+
+// The jobs still queued or running are canceled with their owners
+MultiCheckoutRunner::~MultiCheckoutRunner() = default;
+
+void MultiCheckoutRunner::setExpectRepoChanges(bool expectChanges)
+{
+    m_expectRepoChanges = expectChanges;
+}
+
+void MultiCheckoutRunner::setPerRepository(bool perRepository)
+{
+    m_perRepository = perRepository;
+}
+
+void MultiCheckoutRunner::start()
+{
+    m_timer.start();
+    m_progress.setProgressRange(0, m_topLevels.size());
+    m_progress.reportStarted();
+    m_progressWatcher.setFuture(m_progress.future());
+    Core::ProgressManager::addTask(m_progress.future(), m_title,
+                                   Core::Id("Fossil.MultiCheckout.").withSuffix(m_args.first()));
+
+    QHash<QString, int> repositoryTargets;
+    for (const QString &topLevel : m_topLevels) {
+        if (m_perRepository) {
+            const QString repository = m_client->repositoryKey(topLevel);
+            const auto it = repositoryTargets.constFind(repository);
+            if (it != repositoryTargets.constEnd()) {
+                m_targets[it.value()].topLevels.append(topLevel);
+                continue;
+            }
+            repositoryTargets.insert(repository, m_targets.size());
+        }
+        Target target;
+        target.topLevels.append(topLevel);
+        target.owner = new QObject(this);
+        m_targets.append(target);
+    }
+
+    if (m_targets.isEmpty()) {
+        reportDone();
+        return;
+    }
+
+    // The scheduler bounds the number of the concurrent fossil processes,
+    // and leaves a slot for the interactive commands.
+    for (int index = 0; index < m_targets.size(); ++index) {
+        const Target &target = m_targets.at(index);
+        const auto output = QSharedPointer<QString>::create();
+
+        VcsBase::VcsCommand *cmd = m_client->createCommand(target.topLevels.first());
+        cmd->addFlags(VcsBase::VcsCommand::SuppressCommandLogging
+                      | VcsBase::VcsCommand::SuppressFailMessage
+                      | VcsBase::VcsCommand::MergeOutputChannels);
+        connect(cmd, &VcsBase::VcsCommand::stdOutText, target.owner, [output](const QString &text) {
+            output->append(text);
+        });
+        connect(cmd, &VcsBase::VcsCommand::finished, target.owner, [this, index, output](bool ok) {
+            targetFinished(index, ok, *output);
+        });
+        m_client->enqueueFossilJob(cmd, m_args, JobScheduler::Bulk, target.owner);
+    }
+}
+
+void MultiCheckoutRunner::targetFinished(int index, bool ok, const QString &output)
+{
+    Target &target = m_targets[index];
+    if (target.done)
+        return;
+    target.done = true;
+    m_finishedCount += target.topLevels.size();
+    m_progress.setProgressValue(m_finishedCount);
+
+    QStringList nativeTopLevels;
+    for (const QString &topLevel : qAsConst(target.topLevels))
+        nativeTopLevels.append(QDir::toNativeSeparators(topLevel));
+
+    VcsBase::VcsOutputWindow::appendMessage(nativeTopLevels.join(", ") + ':');
+    const QString trimmedOutput = output.trimmed();
+    if (!trimmedOutput.isEmpty()) {
+        if (ok)
+            VcsBase::VcsOutputWindow::append(trimmedOutput);
+        else
+            VcsBase::VcsOutputWindow::appendError(trimmedOutput);
+    }
+    if (ok) {
+        m_succeededCount += target.topLevels.size();
+        if (m_expectRepoChanges) {
+            for (const QString &topLevel : qAsConst(target.topLevels))
+                emit m_client->changed(QVariant(topLevel));
+        }
+    } else {
+        m_failed.append(nativeTopLevels);
+    }
+
+    if (m_finishedCount >= m_topLevels.size())
+        reportDone();
+}
+
+void MultiCheckoutRunner::cancelTargets()
+{
+    if (m_finishedCount >= m_topLevels.size())
+        return;
+
+    // Drops the queued commands and cancels the running ones,
+    // their output is not reported anymore.
+    for (Target &target : m_targets) {
+        if (target.done)
+            continue;
+        target.done = true;
+        m_client->cancelJobs(target.owner);
+        m_finishedCount += target.topLevels.size();
+        for (const QString &topLevel : qAsConst(target.topLevels))
+            m_cancelled.append(QDir::toNativeSeparators(topLevel));
+    }
+    reportDone();
+}
+
+void MultiCheckoutRunner::reportDone()
+{
+    VcsBase::VcsOutputWindow::appendMessage(
+                tr("%1: %2 of %n check-out(s) succeeded in %3 s.", nullptr, m_topLevels.size())
+                .arg(m_title).arg(m_succeededCount).arg(m_timer.elapsed() / 1000.0, 0, 'f', 1));
+    if (!m_failed.isEmpty())
+        VcsBase::VcsOutputWindow::appendError(tr("Failed: %1").arg(m_failed.join(", ")));
+    if (!m_cancelled.isEmpty())
+        VcsBase::VcsOutputWindow::appendWarning(tr("Canceled: %1").arg(m_cancelled.join(", ")));
+
+    m_progress.reportFinished();
+    emit finished();
+    deleteLater();
+}
+
+} // namespace Internal
+} // namespace Fossil
@@ -0,0 +1,95 @@
+/**************************************************************************
+**  This file is part of Fossil VCS plugin for Qt Creator
+**
+**  Copyright (c) 2013 - 2020, Artur Shepilko, <qtc-fossil@nomadbyte.com>.
+**
+**  Based on Bazaar VCS plugin for Qt Creator by Hugues Delorme.
+**
+**  Permission is hereby granted, free of charge, to any person obtaining a copy
+**  of this software and associated documentation files (the "Software"), to deal
+**  in the Software without restriction, including without limitation the rights
+**  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+**  copies of the Software, and to permit persons to whom the Software is
+**  furnished to do so, subject to the following conditions:
+**
+**  The above copyright notice and this permission notice shall be included in
+**  all copies or substantial portions of the Software.
+**
+**  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+**  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+**  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+**  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+**  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+**  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+**  THE SOFTWARE.
+**************************************************************************/
+
+
+#pragma once
+
+#include <QElapsedTimer>
+#include <QFutureInterface>
+#include <QFutureWatcher>
+#include <QList>
+#include <QObject>
+#include <QStringList>
+
+namespace Fossil {
+namespace Internal {
+
+class FossilClient;
+
+// Runs the same fossil command in a number of check-outs, as bulk jobs of
+// the job scheduler. The output of each check-out goes to the output pane
+// as one block once its command completes, followed by a summary of all.
+// Deletes itself when done.
+
+class MultiCheckoutRunner : public QObject
+{
+    Q_OBJECT
+
+public:
+    MultiCheckoutRunner(FossilClient *client, const QString &title, const QStringList &args,
+                        const QStringList &topLevels, QObject *parent = nullptr);
+    ~MultiCheckoutRunner() override;
+
+    // Reports the check-outs changed on success, for the repository changing commands
+    void setExpectRepoChanges(bool expectChanges);
+    // Runs the command once in the check-outs sharing a repository file,
+    // for the commands of the repository, such as pull
+    void setPerRepository(bool perRepository);
+    void start();
+
+signals:
+    void finished();
+
+private:
+    struct Target {
+        QStringList topLevels;      // the command runs in the first one
+        QObject *owner = nullptr;   // of the job, to cancel it
+        bool done = false;
+    };
+
+    void targetFinished(int index, bool ok, const QString &output);
+    void cancelTargets();
+    void reportDone();
+
+    FossilClient *m_client;
+    const QString m_title;
+    const QStringList m_args;
+    const QStringList m_topLevels;
+    bool m_expectRepoChanges = false;
+    bool m_perRepository = false;
+
+    QList<Target> m_targets;
+    QFutureInterface<void> m_progress;
+    QFutureWatcher<void> m_progressWatcher;
+    QElapsedTimer m_timer;
+    int m_finishedCount = 0;    // of the check-outs
+    int m_succeededCount = 0;
+    QStringList m_failed;
+    QStringList m_cancelled;
+};
+
+} // namespace Internal
+} // namespace Fossil
@@ -63,6 +63,11 @@ void OptionsPageWidget::apply()
     s.setValue(FossilSettings::timelineWidthKey, m_ui.logEntriesWidth->value());
     s.setValue(FossilSettings::timeoutKey, m_ui.timeout->value());
     s.setValue(FossilSettings::disableAutosyncKey, m_ui.disableAutosyncCheckBox->isChecked());
+    s.setValue(FossilSettings::useDatabaseBackendKey, m_ui.useDatabaseBackendCheckBox->isChecked());
+    s.setValue(FossilSettings::inlineBlameKey, m_ui.inlineBlameCheckBox->isChecked());
+    s.setValue(FossilSettings::autoPullIntervalKey, m_ui.autoPullInterval->value());
+    s.setValue(FossilSettings::maxJobsPerCheckoutKey, m_ui.maxJobsPerCheckout->value());
+    s.setValue(FossilSettings::artifactCacheSizeKey, m_ui.artifactCacheSize->value());
     if (*m_settings == s)
         return;
 
@@ -90,6 +95,11 @@ OptionsPageWidget::OptionsPageWidget(const std::function<void()> &onApply, Fossi
     m_ui.logEntriesWidth->setValue(m_settings->intValue(FossilSettings::timelineWidthKey));
     m_ui.timeout->setValue(m_settings->intValue(FossilSettings::timeoutKey));
     m_ui.disableAutosyncCheckBox->setChecked(m_settings->boolValue(FossilSettings::disableAutosyncKey));
+    m_ui.useDatabaseBackendCheckBox->setChecked(m_settings->boolValue(FossilSettings::useDatabaseBackendKey));
+    m_ui.inlineBlameCheckBox->setChecked(m_settings->boolValue(FossilSettings::inlineBlameKey));
+    m_ui.autoPullInterval->setValue(m_settings->intValue(FossilSettings::autoPullIntervalKey));
+    m_ui.maxJobsPerCheckout->setValue(m_settings->intValue(FossilSettings::maxJobsPerCheckoutKey));
+    m_ui.artifactCacheSize->setValue(m_settings->intValue(FossilSettings::artifactCacheSizeKey));
 }
 
 OptionsPage::OptionsPage(const std::function<void()> &onApply, FossilSettings *settings)
@@ -0,0 +1,632 @@
+/**************************************************************************
+**  This file is part of Fossil VCS plugin for Qt Creator
+**
+**  Copyright (c) 2013 - 2020, Artur Shepilko, <qtc-fossil@nomadbyte.com>.
+**
+**  Based on Bazaar VCS plugin for Qt Creator by Hugues Delorme.
+**
+**  Permission is hereby granted, free of charge, to any person obtaining a copy
+**  of this software and associated documentation files (the "Software"), to deal
+**  in the Software without restriction, including without limitation the rights
+**  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+**  copies of the Software, and to permit persons to whom the Software is
+**  furnished to do so, subject to the following conditions:
+**
+**  The above copyright notice and this permission notice shall be included in
+**  all copies or substantial portions of the Software.
+**
+**  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+**  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+**  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+**  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+**  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+**  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+**  THE SOFTWARE.
+**************************************************************************/
+
+
+#include "outputparser.h"
+#include "constants.h"
+
+#include <utils/algorithm.h>
+#include <utils/qtcassert.h>
+
+#include <QRegularExpression>
+
+#include <algorithm>
+#include <cstring>
+
+namespace Fossil {
+namespace Internal {
+
+namespace {
+
+// Ref: fossil source 'src/checkin.c' status_report()
+
+class StatusLabel
+{
+public:
+    const char *label;
+    int size;
+    FileStatus status;
+};
+
+template <int N>
+constexpr StatusLabel statusLabel(const char (&label)[N], FileStatus status)
+{
+    return {label, N - 1, status};
+}
+
+constexpr StatusLabel statusLabels[] = {
+    statusLabel("EDITED", FileStatus::Edited),
+    statusLabel("ADDED", FileStatus::Added),
+    statusLabel("RENAMED", FileStatus::Renamed),
+    statusLabel("DELETED", FileStatus::Deleted),
+    statusLabel("MISSING", FileStatus::Missing),
+    statusLabel("ADDED_BY_MERGE", FileStatus::AddedByMerge),
+    statusLabel("UPDATED_BY_MERGE", FileStatus::UpdatedByMerge),
+    statusLabel("ADDED_BY_INTEGRATE", FileStatus::AddedByIntegrate),
+    statusLabel("UPDATED_BY_INTEGRATE", FileStatus::UpdatedByIntegrate),
+    statusLabel("CONFLICT", FileStatus::Conflict),
+    statusLabel("EXECUTABLE", FileStatus::SetExec),
+    statusLabel("SYMLINK", FileStatus::SetSymlink),
+    statusLabel("UNEXEC", FileStatus::UnsetExec),
+    statusLabel("UNLINK", FileStatus::UnsetSymlink),
+    statusLabel("NOT_A_FILE", FileStatus::Unknown)
+};
+
+constexpr int statusLabelCount = int(sizeof(statusLabels) / sizeof(statusLabels[0]));
+constexpr int statusLabelMinSize = 3;
+constexpr int statusLabelHashSize = 32;
+
+constexpr uint charCode(char c) { return uchar(c); }
+constexpr uint charCode(ushort c) { return c; }
+
+// Perfect for the labels above, checked below
+template <typename Char>
+constexpr int statusLabelHash(const Char *label, int size)
+{
+    return int((uint(size) + charCode(label[0]) + 2 * charCode(label[2])) % statusLabelHashSize);
+}
+
+class StatusLabelTable
+{
+public:
+    constexpr StatusLabelTable() : index()
+    {
+        for (int i = 0; i < statusLabelHashSize; ++i)
+            index[i] = -1;
+        for (int i = 0; i < statusLabelCount; ++i)
+            index[statusLabelHash(statusLabels[i].label, statusLabels[i].size)] = i;
+    }
+
+    constexpr bool isPerfect() const
+    {
+        int used = 0;
+        for (int i = 0; i < statusLabelHashSize; ++i) {
+            if (index[i] >= 0)
+                ++used;
+        }
+        return used == statusLabelCount;
+    }
+
+    int index[statusLabelHashSize];
+};
+
+constexpr StatusLabelTable statusLabelTable;
+static_assert(statusLabelTable.isPerfect(), "The status label hash has collisions.");
+
+// Either Latin-1 or UTF-16 label
+template <typename Char>
+FileStatus statusForLabel(const Char *label, int size)
+{
+    if (size < statusLabelMinSize)
+        return FileStatus::Invalid;
+
+    const int index = statusLabelTable.index[statusLabelHash(label, size)];
+    if (index < 0 || statusLabels[index].size != size)
+        return FileStatus::Invalid;
+
+    const char *expected = statusLabels[index].label;
+    for (int i = 0; i < size; ++i) {
+        if (charCode(label[i]) != charCode(expected[i]))
+            return FileStatus::Invalid;
+    }
+    return statusLabels[index].status;
+}
+
+} // namespace
+
+OutputParser::StatusItem OutputParser::parseStatusLine(const QString &line)
+{
+    StatusItem item;
+
+    // Expect at least one non-leading blank space.
+
+    int pos = line.indexOf(' ');
+
+    if (line.isEmpty() || pos < 1)
+        return StatusItem();
+
+    const FileStatus status = statusForLabel(line.utf16(), pos);
+    if (status == FileStatus::Invalid)
+        return StatusItem();
+
+    // adjust the position to the last space before the file name
+    for (int size = line.size(); (pos+1) < size && line[pos+1].isSpace(); ++pos) {}
+
+    item.flags = statusFlags(status);
+    item.file = line.mid(pos + 1);
+
+    return item;
+}
+
+StatusRecords OutputParser::parseStatus(const QByteArray &output)
+{
+    // "EDITED     src/plugins/fossil/fossilclient.cpp"
+    StatusRecords records;
+    const char *const data = output.constData();
+    const char *const outputEnd = data + output.size();
+    records.reserve(int(std::count(data, outputEnd, '\n')) + 1);
+
+    const char *lineStart = data;
+    while (lineStart < outputEnd) {
+        const char *lineEnd = static_cast<const char *>(
+                    std::memchr(lineStart, '\n', size_t(outputEnd - lineStart)));
+        if (!lineEnd)
+            lineEnd = outputEnd;
+        const char *const labelStart = lineStart;
+        lineStart = lineEnd + 1;
+
+        // Extraneous '\r' in the output of the Windows clients
+        while (lineEnd > labelStart && lineEnd[-1] == '\r')
+            --lineEnd;
+
+        const char *labelEnd = static_cast<const char *>(
+                    std::memchr(labelStart, ' ', size_t(lineEnd - labelStart)));
+        if (!labelEnd || labelEnd == labelStart)
+            continue;
+
+        const FileStatus status = statusForLabel(labelStart, int(labelEnd - labelStart));
+        if (status == FileStatus::Invalid)
+            continue;
+
+        const char *pathStart = labelEnd;
+        while (pathStart < lineEnd && (*pathStart == ' ' || *pathStart == '\t'))
+            ++pathStart;
+        if (pathStart == lineEnd)
+            continue;
+
+        StatusRecord record;
+        record.status = status;
+        record.pathOffset = int(pathStart - data);
+        record.pathSize = int(lineEnd - pathStart);
+        records.append(record);
+    }
+    return records;
+}
+
+const QString &OutputParser::statusFlags(FileStatus status)
+{
+    // Implicitly shared by all the status items
+    static const QString flags[] = {
+        QLatin1String(Constants::FSTATUS_EDITED),
+        QLatin1String(Constants::FSTATUS_ADDED),
+        QLatin1String(Constants::FSTATUS_RENAMED),
+        QLatin1String(Constants::FSTATUS_DELETED),
+        QLatin1String("Missing"),
+        QLatin1String(Constants::FSTATUS_ADDED_BY_MERGE),
+        QLatin1String(Constants::FSTATUS_UPDATED_BY_MERGE),
+        QLatin1String(Constants::FSTATUS_ADDED_BY_INTEGRATE),
+        QLatin1String(Constants::FSTATUS_UPDATED_BY_INTEGRATE),
+        QLatin1String("Conflict"),
+        QLatin1String("Set Exec"),
+        QLatin1String("Set Symlink"),
+        QLatin1String("Unset Exec"),
+        QLatin1String("Unset Symlink"),
+        QLatin1String(Constants::FSTATUS_UNKNOWN),
+        QString()
+    };
+    static_assert(sizeof(flags) / sizeof(flags[0]) == size_t(FileStatus::Invalid) + 1,
+                  "A status flag is missing.");
+
+    return flags[int(status)];
+}
+
+FileStatus OutputParser::fileStatus(const QString &flags)
+{
+    // The flags are normally the shared ones, compare the data first
+    for (int i = 0; i < int(FileStatus::Invalid); ++i) {
+        if (flags.constData() == statusFlags(FileStatus(i)).constData())
+            return FileStatus(i);
+    }
+    for (int i = 0; i < int(FileStatus::Invalid); ++i) {
+        if (flags == statusFlags(FileStatus(i)))
+            return FileStatus(i);
+    }
+    return FileStatus::Invalid;
+}
+
+QList<BranchInfo> OutputParser::parseBranchList(const QString &output,
+                                              const BranchInfo::BranchFlags defaultFlags)
+{
+    // Branch list format:
+    // "  branch-name"
+    // "* current-branch"
+    // Private branches are marked in the leading column by newer clients:
+    // "#  private-branch"
+    // "#* current-private-branch"
+    // Closed state is not marked, it is implied by the listing mode (--closed).
+    return Utils::transform(output.split('\n', QString::SkipEmptyParts), [=](const QString& l) {
+        BranchInfo::BranchFlags flags = defaultFlags;
+        int pos = 0;
+        for (const int size = l.size(); pos < size; ++pos) {
+            const QChar c = l.at(pos);
+            if (c == '*')
+                flags |= BranchInfo::Current;
+            else if (c == '#')
+                flags |= BranchInfo::Private;
+            else if (c != ' ')
+                break;
+        }
+        const QString name = l.mid(pos);
+        QTC_ASSERT(!name.isEmpty(), return BranchInfo());
+        return BranchInfo(name, flags);
+    });
+}
+
+namespace {
+
+// A slice of the parsed output, the bytes are not copied
+class ByteSlice
+{
+public:
+    ByteSlice(const char *begin = nullptr, const char *end = nullptr) : begin(begin), end(end) {}
+
+    int size() const { return int(end - begin); }
+    bool isEmpty() const { return begin == end; }
+    QString toLatin1() const { return QString::fromLatin1(begin, size()); }
+    QString toUtf8() const { return QString::fromUtf8(begin, size()); }
+
+    const char *begin;
+    const char *end;
+};
+
+inline bool isBlank(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+inline bool isHexDigit(char c)
+{
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+inline char toLowerAscii(char c)
+{
+    return (c >= 'A' && c <= 'Z') ? char(c + ('a' - 'A')) : c;
+}
+
+// The key is in lower case
+bool equalsIgnoreCase(const char *text, const char *key, int size)
+{
+    for (int i = 0; i < size; ++i) {
+        if (toLowerAscii(text[i]) != key[i])
+            return false;
+    }
+    return true;
+}
+
+ByteSlice trimmed(ByteSlice slice)
+{
+    while (slice.begin < slice.end && isBlank(*slice.begin))
+        ++slice.begin;
+    while (slice.end > slice.begin && isBlank(slice.end[-1]))
+        --slice.end;
+    return slice;
+}
+
+// Leading hash of the value, such as "<hash> 2020-03-05 14:22:33 UTC"
+ByteSlice hashToken(const ByteSlice &value)
+{
+    const char *end = value.begin;
+    while (end < value.end && isHexDigit(*end))
+        ++end;
+    if (end - value.begin < 5 || (end < value.end && !isBlank(*end)))
+        return ByteSlice();
+    return ByteSlice(value.begin, end);
+}
+
+enum class InfoKey { Checkout, Hash, LegacyHash, Parent, MergedFrom, Comment };
+
+struct InfoKeyEntry
+{
+    const char *name;   // including the colon
+    int size;
+    InfoKey key;
+};
+
+template <int N>
+constexpr InfoKeyEntry infoKeyEntry(const char (&name)[N], InfoKey key)
+{
+    return {name, N - 1, key};
+}
+
+const InfoKeyEntry infoKeyEntries[] = {
+    infoKeyEntry("checkout:", InfoKey::Checkout),
+    infoKeyEntry("hash:", InfoKey::Hash),
+    infoKeyEntry("uuid:", InfoKey::LegacyHash),
+    infoKeyEntry("parent:", InfoKey::Parent),
+    infoKeyEntry("merged-from:", InfoKey::MergedFrom),
+    infoKeyEntry("comment:", InfoKey::Comment)
+};
+
+// "key:   value", the key being followed by a blank
+const InfoKeyEntry *findInfoKey(const ByteSlice &line, ByteSlice *value)
+{
+    const char *colon = static_cast<const char *>(
+                std::memchr(line.begin, ':', size_t(line.size())));
+    if (!colon || colon + 1 == line.end || !isBlank(colon[1]))
+        return nullptr;
+
+    const int keySize = int(colon + 1 - line.begin);
+    for (const InfoKeyEntry &entry : infoKeyEntries) {
+        if (entry.size == keySize && equalsIgnoreCase(line.begin, entry.name, keySize)) {
+            *value = trimmed(ByteSlice(colon + 1, line.end));
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+// "This is a (test) commit message (user: the.name)"
+void parseRevisionComment(const ByteSlice &value, QString *comment, QString *user)
+{
+    static const char userKey[] = "(user: ";
+    const int userKeySize = int(sizeof(userKey)) - 1;
+
+    if (value.size() <= userKeySize || value.end[-1] != ')')
+        return;
+
+    // The comment itself may hold a "(user: " too, take the last one
+    for (const char *p = value.end - userKeySize; p > value.begin; --p) {
+        if (equalsIgnoreCase(p, userKey, userKeySize) && isBlank(p[-1])) {
+            *comment = ByteSlice(value.begin, p - 1).toUtf8();
+            *user = ByteSlice(p + userKeySize, value.end - 1).toUtf8();
+            return;
+        }
+    }
+}
+
+} // namespace
+
+RevisionInfo OutputParser::parseRevisionInfo(const QByteArray &output, bool infoHash, bool getCommentMsg)
+{
+    // Revision info format:
+    // "checkout:     <hash> 2020-03-05 14:22:33 UTC"
+    // "hash:         <hash> 2020-03-05 14:22:33 UTC"  ("uuid:" with legacy clients)
+    // "parent:       <hash> 2020-03-04 10:01:02 UTC"
+    // "merged-from:  <hash> 2020-03-03 09:00:00 UTC"
+    // "comment:      This is a (test) commit message (user: the.name)"
+
+    QString revisionId;
+    QString parentId;
+    QStringList mergeParentIds;
+    QString commentMsg;
+    QString committer;
+
+    const InfoKey hashKey = infoHash ? InfoKey::Hash : InfoKey::LegacyHash;
+
+    const char *lineStart = output.constData();
+    const char *const outputEnd = lineStart + output.size();
+    while (lineStart < outputEnd) {
+        const char *lineEnd = static_cast<const char *>(
+                    std::memchr(lineStart, '\n', size_t(outputEnd - lineStart)));
+        if (!lineEnd)
+            lineEnd = outputEnd;
+        const ByteSlice line(lineStart, lineEnd);
+        lineStart = lineEnd + 1;
+
+        ByteSlice value;
+        const InfoKeyEntry *entry = findInfoKey(line, &value);
+        if (!entry)
+            continue;
+
+        if (entry->key == InfoKey::Checkout || entry->key == hashKey) {
+            const ByteSlice id = hashToken(value);
+            QTC_ASSERT(!id.isEmpty(), return RevisionInfo());
+            revisionId = id.toLatin1();
+        } else if (entry->key == InfoKey::Parent) {
+            const ByteSlice id = hashToken(value);
+            if (!id.isEmpty())
+                parentId = id.toLatin1();
+        } else if (entry->key == InfoKey::MergedFrom) {
+            const ByteSlice id = hashToken(value);
+            if (!id.isEmpty())
+                mergeParentIds.append(id.toLatin1());
+        } else if (getCommentMsg && entry->key == InfoKey::Comment) {
+            commentMsg.clear();
+            committer.clear();
+            parseRevisionComment(value, &commentMsg, &committer);
+        }
+    }
+
+    if (parentId.isEmpty())
+        parentId = revisionId;  // root
+
+    return RevisionInfo(revisionId, parentId, mergeParentIds, commentMsg, committer);
+}
+
+namespace {
+
+// Ref: fossil source 'src/encode.c' fossilize()
+QByteArray fossilized(const QString &text)
+{
+    const QByteArray utf8 = text.toUtf8();
+    QByteArray result;
+    result.reserve(utf8.size());
+    for (const char c : utf8) {
+        char escaped = 0;
+        switch (c) {
+        case '\\': escaped = '\\'; break;
+        case ' ':  escaped = 's'; break;
+        case '\n': escaped = 'n'; break;
+        case '\t': escaped = 't'; break;
+        case '\r': escaped = 'r'; break;
+        case '\v': escaped = 'v'; break;
+        case '\f': escaped = 'f'; break;
+        case '\0': escaped = '0'; break;
+        default: break;
+        }
+        if (escaped) {
+            result.append('\\');
+            result.append(escaped);
+        } else {
+            result.append(c);
+        }
+    }
+    return result;
+}
+
+} // namespace
+
+Utils::optional<QString> OutputParser::parseManifestFileHash(const QByteArray &manifest,
+                                                             const QString &path,
+                                                             QString *baselineId)
+{
+    // Ref: fossil source 'src/manifest.c'
+    // Check-in manifest cards of interest:
+    // "B <baseline-hash>"                                  (delta manifest only)
+    // "F <name> <hash> ?<permissions>? ?<old-name>?"
+    // The names are fossilized. A delta manifest lists the changed files only,
+    // a deleted one with no hash.
+
+    const QByteArray name = fossilized(path);
+
+    const char *lineStart = manifest.constData();
+    const char *const manifestEnd = lineStart + manifest.size();
+    while (lineStart < manifestEnd) {
+        const char *lineEnd = static_cast<const char *>(
+                    std::memchr(lineStart, '\n', size_t(manifestEnd - lineStart)));
+        if (!lineEnd)
+            lineEnd = manifestEnd;
+        const ByteSlice line(lineStart, lineEnd);
+        lineStart = lineEnd + 1;
+
+        if (line.size() < 3 || line.begin[1] != ' ')
+            continue;
+
+        const ByteSlice value(line.begin + 2, line.end);
+        if (line.begin[0] == 'B') {
+            if (baselineId)
+                *baselineId = hashToken(value).toLatin1();
+        } else if (line.begin[0] == 'F') {
+            if (value.size() < name.size()
+                    || std::memcmp(value.begin, name.constData(), size_t(name.size())) != 0
+                    || (value.size() > name.size() && value.begin[name.size()] != ' ')) {
+                continue;
+            }
+            return hashToken(trimmed(ByteSlice(value.begin + name.size(), value.end))).toLatin1();
+        }
+    }
+    return Utils::nullopt;
+}
+
+BlameLines OutputParser::parseBlame(const QString &output)
+{
+    // Ref: fossil source 'src/diff.c' annotate_cmd()
+    // 'fossil blame' line format:
+    //   <hash> <date> <user>: <line text>
+    // The user name is right-aligned and truncated to 13 chars.
+    // The lines past the annotation limit have no hash.
+
+    BlameLines lines;
+    lines.reserve(output.count('\n'));
+
+    int lineStart = 0;
+    while (lineStart < output.size()) {
+        int lineEnd = output.indexOf('\n', lineStart);
+        if (lineEnd < 0)
+            lineEnd = output.size();
+        const QStringRef line = output.midRef(lineStart, lineEnd - lineStart);
+        lineStart = lineEnd + 1;
+
+        BlameLine blameLine;
+        const int hashEnd = line.indexOf(' ');
+        const int dateEnd = hashEnd > 0 ? line.indexOf(' ', hashEnd + 1) : -1;
+        const int userEnd = dateEnd > 0 ? line.indexOf(": ", dateEnd) : -1;
+        if (userEnd > 0) {
+            const QStringRef hash = line.left(hashEnd);
+            const bool isHash = std::all_of(hash.cbegin(), hash.cend(), [](QChar c) {
+                return c.isDigit() || (c >= 'a' && c <= 'f');
+            });
+            if (isHash) {
+                blameLine.changeId = hash.toString();
+                blameLine.date = QDate::fromString(line.mid(hashEnd + 1, dateEnd - hashEnd - 1).toString(),
+                                                   Qt::ISODate);
+                blameLine.user = line.mid(dateEnd, userEnd - dateEnd).trimmed().toString();
+            }
+        }
+        // The lines past the limit keep the aligned colon of the prefix
+        const int textStart = blameLine.changeId.isEmpty() ? line.indexOf(':') + 2 : userEnd + 2;
+        if (textStart > 1)
+            blameLine.text = line.mid(textStart).toString();
+        lines.append(blameLine);
+    }
+    return lines;
+}
+
+QString OutputParser::parseRepositoryFile(const QString &output)
+{
+    // 'fossil info' line format:
+    //   repository:   /home/user/project.fossil
+    const QLatin1String key("repository:");
+    for (const QStringRef &line : output.splitRef('\n')) {
+        if (line.startsWith(key))
+            return line.mid(key.size()).trimmed().toString();
+    }
+    return QString();
+}
+
+int OutputParser::parseSyncProgress(const QString &output, SyncProgress *progress, bool isChunk)
+{
+    // Ref: fossil source 'src/xfer.c' client_sync()
+    // The progress line is rewritten after each round-trip:
+    //   Round-trips: 2   Artifacts sent: 0  received: 15
+    // Followed by the summary, with "wire bytes" in the later versions:
+    //   Pull done, sent: 1126  received: 2890  ip: 10.0.0.1
+    //   Pull done, wire bytes sent: 1126  received: 2890  ip: 10.0.0.1
+
+    QTC_ASSERT(progress, return 0);
+
+    static const QRegularExpression roundTripRx(
+                "Round-trips:\\s+(\\d+)\\s+Artifacts sent:\\s+(\\d+)\\s+received:\\s+(\\d+)");
+    static const QRegularExpression doneRx(
+                "done, (?:wire bytes )?sent:\\s+(\\d+)\\s+received:\\s+(\\d+)");
+    QTC_ASSERT(roundTripRx.isValid() && doneRx.isValid(), return 0);
+
+    // A line cut within a number would report a part of it
+    const int length = isChunk
+            ? qMax(output.lastIndexOf('\n'), output.lastIndexOf('\r')) + 1
+            : output.size();
+    const QString text = output.left(length);
+
+    QRegularExpressionMatchIterator it = roundTripRx.globalMatch(text);
+    while (it.hasNext()) {
+        const QRegularExpressionMatch match = it.next();
+        progress->roundTrips = match.captured(1).toInt();
+        progress->artifactsSent = match.captured(2).toInt();
+        progress->artifactsReceived = match.captured(3).toInt();
+    }
+
+    const QRegularExpressionMatch doneMatch = doneRx.match(text);
+    if (doneMatch.hasMatch()) {
+        progress->bytesSent = doneMatch.captured(1).toLongLong();
+        progress->bytesReceived = doneMatch.captured(2).toLongLong();
+        progress->isDone = true;
+    }
+    return length;
+}
+
+} // namespace Internal
+} // namespace Fossil
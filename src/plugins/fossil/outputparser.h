@@ -0,0 +1,124 @@
+/**************************************************************************
+**  This file is part of Fossil VCS plugin for Qt Creator
+**
+**  Copyright (c) 2013 - 2020, Artur Shepilko, <qtc-fossil@nomadbyte.com>.
+**
+**  Based on Bazaar VCS plugin for Qt Creator by Hugues Delorme.
+**
+**  Permission is hereby granted, free of charge, to any person obtaining a copy
+**  of this software and associated documentation files (the "Software"), to deal
+**  in the Software without restriction, including without limitation the rights
+**  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+**  copies of the Software, and to permit persons to whom the Software is
+**  furnished to do so, subject to the following conditions:
+**
+**  The above copyright notice and this permission notice shall be included in
+**  all copies or substantial portions of the Software.
+**
+**  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+**  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+**  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+**  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+**  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+**  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+**  THE SOFTWARE.
+**************************************************************************/
+
+
+#pragma once
+
+#include "annotationcache.h"
+#include "branchinfo.h"
+#include "revisioninfo.h"
+
+#include <utils/optional.h>
+#include <vcsbase/vcsbaseclient.h>
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+namespace Fossil {
+namespace Internal {
+
+// Transfer counters of a pull, push or sync, as reported so far
+class SyncProgress
+{
+public:
+    int roundTrips = 0;
+    int artifactsSent = 0;
+    int artifactsReceived = 0;
+    qint64 bytesSent = 0;
+    qint64 bytesReceived = 0;
+    bool isDone = false;
+};
+
+// File status, as reported by 'fossil changes' and 'fossil status'
+enum class FileStatus : quint8 {
+    Edited,
+    Added,
+    Renamed,
+    Deleted,
+    Missing,
+    AddedByMerge,
+    UpdatedByMerge,
+    AddedByIntegrate,
+    UpdatedByIntegrate,
+    Conflict,
+    SetExec,
+    SetSymlink,
+    UnsetExec,
+    UnsetSymlink,
+    Unknown,        // not a file
+    Invalid
+};
+
+// Status of a file in the parsed output, the path being a slice of it
+class StatusRecord
+{
+public:
+    FileStatus status = FileStatus::Invalid;
+    int pathOffset = 0;
+    int pathSize = 0;
+};
+
+using StatusRecords = QVector<StatusRecord>;
+
+// Parsers of the fossil command-line output.
+// Stateless, safe to use from any thread.
+
+class OutputParser
+{
+public:
+    using StatusItem = VcsBase::VcsBaseClient::StatusItem;
+
+    static StatusItem parseStatusLine(const QString &line);
+    // Parses the raw status output in a single pass, the paths are left in place
+    static StatusRecords parseStatus(const QByteArray &output);
+    // Shared status flag strings, as displayed
+    static const QString &statusFlags(FileStatus status);
+    static FileStatus fileStatus(const QString &flags);
+    static QList<BranchInfo> parseBranchList(const QString &output,
+                                             const BranchInfo::BranchFlags defaultFlags = {});
+    // Parses the raw 'fossil info' output in place
+    static RevisionInfo parseRevisionInfo(const QByteArray &output, bool infoHash, bool getCommentMsg);
+    static BlameLines parseBlame(const QString &output);
+    // Repository file of the check-out, as given by 'fossil info'
+    static QString parseRepositoryFile(const QString &output);
+    // Hash of the file in the raw check-in manifest, empty when the file is deleted in
+    // a delta manifest, nullopt when not listed. A delta manifest reports its baseline.
+    static Utils::optional<QString> parseManifestFileHash(const QByteArray &manifest,
+                                                          const QString &path,
+                                                          QString *baselineId = nullptr);
+    // Updates the counters from the sync output. Of a chunk only the terminated lines
+    // are parsed, the rest is left for the next chunk. Returns the length parsed.
+    static int parseSyncProgress(const QString &output, SyncProgress *progress,
+                                 bool isChunk = false);
+};
+
+} // namespace Internal
+} // namespace Fossil
+
+Q_DECLARE_TYPEINFO(Fossil::Internal::StatusRecord, Q_PRIMITIVE_TYPE)
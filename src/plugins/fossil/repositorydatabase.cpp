@@ -0,0 +1,460 @@
+/**************************************************************************
+**  This file is part of Fossil VCS plugin for Qt Creator
+**
+**  Copyright (c) 2013 - 2020, Artur Shepilko, <qtc-fossil@nomadbyte.com>.
+**
+**  Based on Bazaar VCS plugin for Qt Creator by Hugues Delorme.
+**
+**  Permission is hereby granted, free of charge, to any person obtaining a copy
+**  of this software and associated documentation files (the "Software"), to deal
+**  in the Software without restriction, including without limitation the rights
+**  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+**  copies of the Software, and to permit persons to whom the Software is
+**  furnished to do so, subject to the following conditions:
+**
+**  The above copyright notice and this permission notice shall be included in
+**  all copies or substantial portions of the Software.
+**
+**  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+**  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+**  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+**  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+**  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+**  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+**  THE SOFTWARE.
+**************************************************************************/
+
+
+#include "repositorydatabase.h"
+#include "constants.h"
+
+#include <utils/qtcassert.h>
+
+#include <QAtomicInt>
+#include <QDir>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QRegularExpression>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QThreadStorage>
+#include <QVariant>
+
+#include <algorithm>
+
+namespace Fossil {
+namespace Internal {
+
+// Repository schema versions ('aux-schema' config) the queries are known to work with.
+static const char *const knownAuxSchemas[] = {
+    "2011-04-25",
+    "2011-08-14",
+    "2015-01-24"
+};
+
+static QString nextConnectionName(const char *kind)
+{
+    static QAtomicInt connectionCount;
+    return QString::fromLatin1("Fossil.%1.%2").arg(QLatin1String(kind))
+            .arg(connectionCount.fetchAndAddRelaxed(1));
+}
+
+static bool openReadOnly(const QString &connectionName, const QString &fileName)
+{
+    if (!QFileInfo(fileName).isFile())
+        return false;
+
+    QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+    db.setDatabaseName(fileName);
+    // Fossil may hold a write lock for a short while, don't give up on the first try.
+    db.setConnectOptions("QSQLITE_OPEN_READONLY;QSQLITE_BUSY_TIMEOUT=500");
+    return db.open();
+}
+
+namespace {
+
+struct KeptDatabase {
+    QSharedPointer<const RepositoryDatabase> database;
+    int generation = 0;     // of the closings, when opened
+};
+
+struct ThreadDatabases {
+    QHash<QString, KeptDatabase> databases;     // by the top-level
+    int generation = 0;     // of the closings, when last released
+};
+
+} // namespace
+
+// The closings of the kept databases, counted up by closeKept()
+static QAtomicInt closingGeneration;
+static QMutex closingMutex;
+static int allClosedGeneration = 0;
+static QHash<QString, int> closedGenerations;  // by the top-level
+
+static ThreadDatabases &threadDatabases()
+{
+    // A connection may only be used by the thread it was opened in
+    static QThreadStorage<ThreadDatabases> databases;
+    return databases.localData();
+}
+
+static void releaseClosedDatabases(ThreadDatabases &threadDatabases)
+{
+    const int generation = closingGeneration.loadAcquire();
+    if (generation == threadDatabases.generation)
+        return;
+
+    QMutexLocker locker(&closingMutex);
+    QHash<QString, KeptDatabase> &databases = threadDatabases.databases;
+    for (auto it = databases.begin(); it != databases.end(); ) {
+        const int closedGeneration = qMax(allClosedGeneration, closedGenerations.value(it.key()));
+        if (it->generation < closedGeneration)
+            it = databases.erase(it);
+        else
+            ++it;
+    }
+    threadDatabases.generation = generation;
+}
+
+static void closeConnection(const QString &connectionName)
+{
+    if (connectionName.isEmpty())
+        return;
+
+    {
+        QSqlDatabase db = QSqlDatabase::database(connectionName, false);
+        db.close();
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+}
+
+RepositoryDatabase::RepositoryDatabase(const QString &topLevel)
+{
+    if (topLevel.isEmpty() || !QSqlDatabase::isDriverAvailable("QSQLITE"))
+        return;
+
+    // Taken before the open, a change meanwhile makes the database outdated
+    m_checkoutFile = QDir(topLevel).absoluteFilePath(Constants::FOSSILREPO);
+    const QFileInfo checkoutInfo(m_checkoutFile);
+    m_checkoutCreated = checkoutInfo.birthTime();
+    m_checkoutModified = checkoutInfo.lastModified();
+
+    m_checkoutConnection = nextConnectionName("checkout");
+    if (!openReadOnly(m_checkoutConnection, m_checkoutFile))
+        return;
+
+    m_repositoryFile = checkoutVariable("repository");
+    if (m_repositoryFile.isEmpty() || checkoutRid() <= 0)
+        return;
+
+    // Repository path is stored as given to 'fossil open', it may be relative.
+    m_repositoryFile = QDir(topLevel).absoluteFilePath(m_repositoryFile);
+
+    m_repositoryConnection = nextConnectionName("repository");
+    if (!openReadOnly(m_repositoryConnection, m_repositoryFile))
+        return;
+
+    QSqlQuery query(QSqlDatabase::database(m_repositoryConnection, false));
+    query.prepare("SELECT value FROM config WHERE name='aux-schema'");
+    if (!query.exec() || !query.next())
+        return;
+
+    const QString auxSchema = query.value(0).toString();
+    m_isValid = std::any_of(std::begin(knownAuxSchemas), std::end(knownAuxSchemas),
+                            [&auxSchema](const char *schema) { return auxSchema == schema; });
+}
+
+RepositoryDatabase::~RepositoryDatabase()
+{
+    closeConnection(m_repositoryConnection);
+    closeConnection(m_checkoutConnection);
+}
+
+QSharedPointer<const RepositoryDatabase> RepositoryDatabase::forCheckout(const QString &topLevel)
+{
+    // Opening the databases and checking the schema is left out of the queries.
+    // A closed or re-opened check-out replaces its database file, an open
+    // connection would keep answering from the old one.
+
+    if (topLevel.isEmpty())
+        return {};
+
+    ThreadDatabases &databases = threadDatabases();
+    releaseClosedDatabases(databases);
+
+    KeptDatabase &kept = databases.databases[topLevel];
+    if (!kept.database || !kept.database->isValid() || !kept.database->isCurrent()) {
+        // The previous connections are closed first, on Windows they keep the file in use
+        kept.database.reset();
+        kept.generation = closingGeneration.loadAcquire();
+        kept.database.reset(new RepositoryDatabase(topLevel));
+    }
+    if (!kept.database->isValid())
+        return {};
+    return kept.database;
+}
+
+void RepositoryDatabase::closeKept(const QString &topLevel)
+{
+    QMutexLocker locker(&closingMutex);
+    const int generation = closingGeneration.fetchAndAddOrdered(1) + 1;
+    if (topLevel.isEmpty()) {
+        allClosedGeneration = generation;
+        closedGenerations.clear();
+    } else {
+        closedGenerations.insert(topLevel, generation);
+    }
+}
+
+void RepositoryDatabase::releaseClosed()
+{
+    releaseClosedDatabases(threadDatabases());
+}
+
+bool RepositoryDatabase::isValid() const
+{
+    return m_isValid;
+}
+
+bool RepositoryDatabase::isCurrent() const
+{
+    const QFileInfo checkoutInfo(m_checkoutFile);
+    return checkoutInfo.isFile() && checkoutInfo.birthTime() == m_checkoutCreated
+            && checkoutInfo.lastModified() == m_checkoutModified;
+}
+
+QString RepositoryDatabase::repositoryFile() const
+{
+    return m_repositoryFile;
+}
+
+QString RepositoryDatabase::checkoutVariable(const QString &name) const
+{
+    QSqlQuery query(QSqlDatabase::database(m_checkoutConnection, false));
+    query.prepare("SELECT value FROM vvar WHERE name=?");
+    query.addBindValue(name);
+    if (!query.exec() || !query.next())
+        return QString();
+    return query.value(0).toString();
+}
+
+int RepositoryDatabase::checkoutRid() const
+{
+    return checkoutVariable("checkout").toInt();
+}
+
+int RepositoryDatabase::resolveCheckin(const QString &id, QString *revisionId) const
+{
+    // Resolve current check-out or a (partial) check-in hash to its record id.
+    // Symbolic names (tags, branches, dates) are left to the fossil client.
+
+    QSqlQuery query(QSqlDatabase::database(m_repositoryConnection, false));
+
+    if (id.isEmpty()) {
+        query.prepare("SELECT rid, uuid FROM blob WHERE rid=?");
+        query.addBindValue(checkoutRid());
+    } else {
+        static const QRegularExpression hashRx("^[0-9a-fA-F]{4,64}$");
+        QTC_ASSERT(hashRx.isValid(), return 0);
+        if (!hashRx.match(id).hasMatch())
+            return 0;
+
+        query.prepare("SELECT blob.rid, blob.uuid FROM blob JOIN event ON event.objid=blob.rid"
+                      " WHERE blob.uuid GLOB ? AND event.type='ci' LIMIT 2");
+        query.addBindValue(id.toLower() + '*');
+    }
+
+    if (!query.exec() || !query.next())
+        return 0;
+
+    const int rid = query.value(0).toInt();
+    const QString uuid = query.value(1).toString();
+
+    // ambiguous prefix
+    if (query.next())
+        return 0;
+
+    if (revisionId)
+        *revisionId = uuid;
+    return rid;
+}
+
+Utils::optional<QList<BranchInfo>> RepositoryDatabase::branches() const
+{
+    // Ref: fossil source 'src/branch.c' branch_prepare_list_query()
+
+    if (!m_isValid)
+        return Utils::nullopt;
+
+    QSqlQuery query(QSqlDatabase::database(m_repositoryConnection, false));
+    query.prepare("SELECT tagxref.value, max(event.mtime),"
+                  " EXISTS(SELECT 1 FROM tagxref AS tx"
+                  "         WHERE tx.rid=tagxref.rid"
+                  "           AND tx.tagid=(SELECT tagid FROM tag WHERE tagname='closed')"
+                  "           AND tx.tagtype>0),"
+                  " EXISTS(SELECT 1 FROM private WHERE rid=tagxref.rid)"
+                  " FROM tagxref, tag, event"
+                  " WHERE tagxref.tagid=tag.tagid"
+                  "   AND tagxref.tagtype>0"
+                  "   AND tag.tagname='branch'"
+                  "   AND event.objid=tagxref.rid"
+                  " GROUP BY 1 ORDER BY 1");
+    if (!query.exec())
+        return Utils::nullopt;
+
+    QList<BranchInfo> branches;
+    while (query.next()) {
+        BranchInfo::BranchFlags flags;
+        if (query.value(2).toBool())
+            flags |= BranchInfo::Closed;
+        if (query.value(3).toBool())
+            flags |= BranchInfo::Private;
+        branches.append(BranchInfo(query.value(0).toString(), flags));
+    }
+
+    // Mark the branch of the current check-out
+    query.prepare("SELECT value FROM tagxref"
+                  " WHERE rid=? AND tagtype>0"
+                  "   AND tagid=(SELECT tagid FROM tag WHERE tagname='branch')");
+    query.addBindValue(checkoutRid());
+    if (!query.exec())
+        return Utils::nullopt;
+
+    if (query.next()) {
+        const QString currentName = query.value(0).toString();
+        for (BranchInfo &branch : branches) {
+            if (branch.name() == currentName) {
+                branch = BranchInfo(currentName, branch.flags() | BranchInfo::Current);
+                break;
+            }
+        }
+    }
+
+    return branches;
+}
+
+Utils::optional<QStringList> RepositoryDatabase::tags(const QString &id) const
+{
+    // Ref: fossil source 'src/tag.c' tag_cmd() "list"
+    // Only symbolic tags are listed, with the "sym-" prefix removed.
+
+    if (!m_isValid)
+        return Utils::nullopt;
+
+    QSqlQuery query(QSqlDatabase::database(m_repositoryConnection, false));
+    if (id.isEmpty()) {
+        query.prepare("SELECT substr(tagname, 5) FROM tag"
+                      " WHERE tagname GLOB 'sym-*'"
+                      "   AND EXISTS(SELECT 1 FROM tagxref WHERE tagid=tag.tagid AND tagtype>0)"
+                      " ORDER BY tagname");
+    } else {
+        const int rid = resolveCheckin(id);
+        if (!rid)
+            return Utils::nullopt;
+
+        query.prepare("SELECT substr(tagname, 5) FROM tagxref, tag"
+                      " WHERE tagxref.rid=? AND tagxref.tagid=tag.tagid"
+                      "   AND tagtype>0 AND tagname GLOB 'sym-*'"
+                      " ORDER BY tagname");
+        query.addBindValue(rid);
+    }
+
+    if (!query.exec())
+        return Utils::nullopt;
+
+    QStringList tags;
+    while (query.next())
+        tags.append(query.value(0).toString());
+    return tags;
+}
+
+Utils::optional<RevisionInfo> RepositoryDatabase::revision(const QString &id) const
+{
+    if (!m_isValid)
+        return Utils::nullopt;
+
+    QString revisionId;
+    const int rid = resolveCheckin(id, &revisionId);
+    if (!rid)
+        return Utils::nullopt;
+
+    QSqlQuery query(QSqlDatabase::database(m_repositoryConnection, false));
+    query.prepare("SELECT blob.uuid, plink.isprim FROM plink JOIN blob ON blob.rid=plink.pid"
+                  " WHERE plink.cid=? ORDER BY plink.isprim DESC");
+    query.addBindValue(rid);
+    if (!query.exec())
+        return Utils::nullopt;
+
+    QString parentId;
+    QStringList mergeParentIds;
+    while (query.next()) {
+        if (query.value(1).toBool())
+            parentId = query.value(0).toString();
+        else
+            mergeParentIds.append(query.value(0).toString());
+    }
+
+    if (parentId.isEmpty())
+        parentId = revisionId;  // root
+
+    query.prepare("SELECT coalesce(ecomment, comment), coalesce(euser, user)"
+                  " FROM event WHERE objid=?");
+    query.addBindValue(rid);
+    if (!query.exec())
+        return Utils::nullopt;
+
+    QString commentMsg;
+    QString committer;
+    if (query.next()) {
+        commentMsg = query.value(0).toString();
+        committer = query.value(1).toString();
+    }
+
+    return RevisionInfo(revisionId, parentId, mergeParentIds, commentMsg, committer);
+}
+
+Utils::optional<QString> RepositoryDatabase::userDefault() const
+{
+    // Ref: fossil source 'src/user.c' user_select()
+    // The check-out setting takes precedence over the repository one.
+    // Environment-derived defaults are left to the fossil client.
+
+    if (!m_isValid)
+        return Utils::nullopt;
+
+    const QString checkoutUser = checkoutVariable("default-user");
+    if (!checkoutUser.isEmpty())
+        return checkoutUser;
+
+    QSqlQuery query(QSqlDatabase::database(m_repositoryConnection, false));
+    query.prepare("SELECT value FROM config WHERE name='default-user'");
+    if (!query.exec() || !query.next() || query.value(0).toString().isEmpty())
+        return Utils::nullopt;
+
+    return query.value(0).toString();
+}
+
+Utils::optional<QStringList> RepositoryDatabase::managedFiles() const
+{
+    // Ref: fossil source 'src/checkin.c' ls_cmd()
+    // Files of the current check-out, including the added and the deleted ones.
+
+    if (!m_isValid)
+        return Utils::nullopt;
+
+    QSqlQuery query(QSqlDatabase::database(m_checkoutConnection, false));
+    query.setForwardOnly(true);
+    query.prepare("SELECT pathname FROM vfile WHERE vid=?");
+    query.addBindValue(checkoutRid());
+    if (!query.exec())
+        return Utils::nullopt;
+
+    QStringList files;
+    while (query.next())
+        files.append(query.value(0).toString());
+    return files;
+}
+
+} // namespace Internal
+} // namespace Fossil
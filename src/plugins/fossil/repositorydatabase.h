@@ -0,0 +1,91 @@
+/**************************************************************************
+**  This file is part of Fossil VCS plugin for Qt Creator
+**
+**  Copyright (c) 2013 - 2020, Artur Shepilko, <qtc-fossil@nomadbyte.com>.
+**
+**  Based on Bazaar VCS plugin for Qt Creator by Hugues Delorme.
+**
+**  Permission is hereby granted, free of charge, to any person obtaining a copy
+**  of this software and associated documentation files (the "Software"), to deal
+**  in the Software without restriction, including without limitation the rights
+**  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+**  copies of the Software, and to permit persons to whom the Software is
+**  furnished to do so, subject to the following conditions:
+**
+**  The above copyright notice and this permission notice shall be included in
+**  all copies or substantial portions of the Software.
+**
+**  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+**  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+**  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+**  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+**  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+**  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+**  THE SOFTWARE.
+**************************************************************************/
+
+
+#pragma once
+
+#include "branchinfo.h"
+#include "revisioninfo.h"
+
+#include <utils/optional.h>
+
+#include <QDateTime>
+#include <QList>
+#include <QSharedPointer>
+#include <QString>
+#include <QStringList>
+
+namespace Fossil {
+namespace Internal {
+
+// Read-only access to the check-out (.fslckout) and the repository (.fossil)
+// databases of a Fossil check-out.
+// Queries return nullopt whenever the answer cannot be given reliably,
+// in such case the caller should fall back to the fossil client.
+// The connections belong to the thread that opened them.
+
+class RepositoryDatabase
+{
+public:
+    explicit RepositoryDatabase(const QString &topLevel);
+    ~RepositoryDatabase();
+
+    // Kept open per check-out for the calling thread, null when not valid.
+    // Opened again once the check-out database file is replaced or modified.
+    static QSharedPointer<const RepositoryDatabase> forCheckout(const QString &topLevel);
+    // Closes the kept databases of the check-out, of all check-outs when empty.
+    // Each thread closes its connections on its next call of forCheckout() or releaseClosed().
+    static void closeKept(const QString &topLevel = QString());
+    static void releaseClosed();
+
+    bool isValid() const;
+    // The check-out database file is still the one opened, and not modified since
+    bool isCurrent() const;
+    QString repositoryFile() const;
+
+    Utils::optional<QList<BranchInfo>> branches() const;
+    Utils::optional<QStringList> tags(const QString &id = QString()) const;
+    Utils::optional<RevisionInfo> revision(const QString &id = QString()) const;
+    Utils::optional<QString> userDefault() const;
+    Utils::optional<QStringList> managedFiles() const;
+
+private:
+    int resolveCheckin(const QString &id, QString *revisionId = nullptr) const;
+    QString checkoutVariable(const QString &name) const;
+    // Re-read on each query, an open database outlives the updates of the check-out
+    int checkoutRid() const;
+
+    QString m_checkoutFile;
+    QDateTime m_checkoutCreated;
+    QDateTime m_checkoutModified;
+    QString m_checkoutConnection;
+    QString m_repositoryConnection;
+    QString m_repositoryFile;
+    bool m_isValid = false;
+};
+
+} // namespace Internal
+} // namespace Fossil
@@ -0,0 +1,104 @@
+/**************************************************************************
+**  This file is part of Fossil VCS plugin for Qt Creator
+**
+**  Copyright (c) 2013 - 2020, Artur Shepilko, <qtc-fossil@nomadbyte.com>.
+**
+**  Based on Bazaar VCS plugin for Qt Creator by Hugues Delorme.
+**
+**  Permission is hereby granted, free of charge, to any person obtaining a copy
+**  of this software and associated documentation files (the "Software"), to deal
+**  in the Software without restriction, including without limitation the rights
+**  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+**  copies of the Software, and to permit persons to whom the Software is
+**  furnished to do so, subject to the following conditions:
+**
+**  The above copyright notice and this permission notice shall be included in
+**  all copies or substantial portions of the Software.
+**
+**  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+**  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+**  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+**  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+**  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+**  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+**  THE SOFTWARE.
+**************************************************************************/
+
+
+#include "revisioncache.h"
+
+namespace Fossil {
+namespace Internal {
+
+RevisionCache::RevisionCache(int capacity) :
+    m_capacity(qMax(1, capacity))
+{ }
+
+Utils::optional<RevisionInfo> RevisionCache::find(const QString &repository, const QString &id)
+{
+    const QString idKey = key(repository, id);
+    QMutexLocker locker(&m_mutex);
+
+    auto it = m_entries.find(m_aliases.value(idKey, idKey));
+    if (it == m_entries.end())
+        return Utils::nullopt;
+
+    m_lruKeys.splice(m_lruKeys.begin(), m_lruKeys, it->lruPosition);
+    return *it->revisionInfo;
+}
+
+void RevisionCache::insert(const QString &repository, const RevisionInfo &revisionInfo,
+                           const QString &id)
+{
+    if (revisionInfo.id.isEmpty())
+        return;
+
+    const QString entryKey = key(repository, revisionInfo.id);
+    const bool isPrefix = !id.isEmpty() && revisionInfo.id.startsWith(id, Qt::CaseInsensitive);
+    const QString aliasKey = isPrefix ? key(repository, id) : QString();
+    QMutexLocker locker(&m_mutex);
+
+    auto it = m_entries.find(entryKey);
+    if (it != m_entries.end()) {
+        it->revisionInfo.reset(new RevisionInfo(revisionInfo));
+        m_lruKeys.splice(m_lruKeys.begin(), m_lruKeys, it->lruPosition);
+    } else {
+        while (m_entries.size() >= m_capacity) {
+            const Entry evicted = m_entries.take(m_lruKeys.back());
+            for (const QString &alias : evicted.aliases)
+                m_aliases.remove(alias);
+            m_lruKeys.pop_back();
+        }
+
+        m_lruKeys.push_front(entryKey);
+        it = m_entries.insert(entryKey, {QSharedPointer<const RevisionInfo>(new RevisionInfo(revisionInfo)),
+                                         m_lruKeys.begin(), QStringList()});
+    }
+
+    if (!aliasKey.isEmpty() && aliasKey != entryKey && !m_aliases.contains(aliasKey)) {
+        m_aliases.insert(aliasKey, entryKey);
+        it->aliases.append(aliasKey);
+    }
+}
+
+void RevisionCache::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_entries.clear();
+    m_aliases.clear();
+    m_lruKeys.clear();
+}
+
+int RevisionCache::size() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_entries.size();
+}
+
+QString RevisionCache::key(const QString &repository, const QString &id)
+{
+    return repository + QLatin1Char('\n') + id.toLower();
+}
+
+} // namespace Internal
+} // namespace Fossil
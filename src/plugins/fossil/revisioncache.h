@@ -0,0 +1,82 @@
+/**************************************************************************
+**  This file is part of Fossil VCS plugin for Qt Creator
+**
+**  Copyright (c) 2013 - 2020, Artur Shepilko, <qtc-fossil@nomadbyte.com>.
+**
+**  Based on Bazaar VCS plugin for Qt Creator by Hugues Delorme.
+**
+**  Permission is hereby granted, free of charge, to any person obtaining a copy
+**  of this software and associated documentation files (the "Software"), to deal
+**  in the Software without restriction, including without limitation the rights
+**  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+**  copies of the Software, and to permit persons to whom the Software is
+**  furnished to do so, subject to the following conditions:
+**
+**  The above copyright notice and this permission notice shall be included in
+**  all copies or substantial portions of the Software.
+**
+**  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+**  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+**  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+**  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+**  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+**  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+**  THE SOFTWARE.
+**************************************************************************/
+
+
+#pragma once
+
+#include "revisioninfo.h"
+
+#include <utils/optional.h>
+
+#include <QHash>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QStringList>
+
+#include <list>
+
+namespace Fossil {
+namespace Internal {
+
+// Bounded LRU cache of check-in details keyed by the repository and the full hash.
+// Committed check-ins never change, so entries need no invalidation.
+// Thread-safe, lookups may come from the query pool.
+
+class RevisionCache
+{
+public:
+    explicit RevisionCache(int capacity = 1024);
+
+    // Lookup by a full hash, or by an id the entry was inserted for, such as a hash prefix.
+    // A prefix is never matched against the cached hashes, the cache holds only a part
+    // of the repository and cannot tell it is unique there.
+    Utils::optional<RevisionInfo> find(const QString &repository, const QString &id);
+    // The id is the one the revision was resolved from. It becomes an alias of the entry
+    // only when it is a prefix of the hash, a symbolic name may move to another check-in.
+    void insert(const QString &repository, const RevisionInfo &revisionInfo,
+                const QString &id = QString());
+    void clear();
+
+    int size() const;
+
+private:
+    struct Entry {
+        QSharedPointer<const RevisionInfo> revisionInfo;
+        std::list<QString>::iterator lruPosition;
+        QStringList aliases;
+    };
+
+    static QString key(const QString &repository, const QString &id);
+
+    const int m_capacity;
+    mutable QMutex m_mutex;
+    QHash<QString, Entry> m_entries;
+    QHash<QString, QString> m_aliases; // alias key to entry key
+    std::list<QString> m_lruKeys; // most recently used first
+};
+
+} // namespace Internal
+} // namespace Fossil
@@ -0,0 +1,83 @@
+/**************************************************************************
+**  This file is part of Fossil VCS plugin for Qt Creator
+**
+**  Copyright (c) 2013 - 2020, Artur Shepilko, <qtc-fossil@nomadbyte.com>.
+**
+**  Based on Bazaar VCS plugin for Qt Creator by Hugues Delorme.
+**
+**  Permission is hereby granted, free of charge, to any person obtaining a copy
+**  of this software and associated documentation files (the "Software"), to deal
+**  in the Software without restriction, including without limitation the rights
+**  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+**  copies of the Software, and to permit persons to whom the Software is
+**  furnished to do so, subject to the following conditions:
+**
+**  The above copyright notice and this permission notice shall be included in
+**  all copies or substantial portions of the Software.
+**
+**  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+**  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+**  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+**  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+**  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+**  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+**  THE SOFTWARE.
+**************************************************************************/
+
+
+#pragma once
+
+#include <utils/optional.h>
+
+#include <QHash>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QString>
+#include <QWaitCondition>
+
+namespace Fossil {
+namespace Internal {
+
+// Coalesces the identical requests run at the same time from different
+// threads: the first one runs the function, the later ones wait for it
+// and share its result. Nothing is kept once the first one is done.
+
+template <typename T>
+class SingleFlight
+{
+public:
+    template <typename Function>
+    T run(const QString &key, const Function &function)
+    {
+        QMutexLocker locker(&m_mutex);
+        if (const QSharedPointer<Flight> flight = m_flights.value(key)) {
+            while (!flight->result)
+                m_landed.wait(&m_mutex);
+            return *flight->result;
+        }
+
+        const auto flight = QSharedPointer<Flight>::create();
+        m_flights.insert(key, flight);
+        locker.unlock();
+
+        const T result = function();
+
+        locker.relock();
+        flight->result.emplace(result);
+        m_flights.remove(key);
+        m_landed.wakeAll();
+        return result;
+    }
+
+private:
+    struct Flight {
+        Utils::optional<T> result;
+    };
+
+    QMutex m_mutex;
+    QWaitCondition m_landed;
+    QHash<QString, QSharedPointer<Flight>> m_flights;
+};
+
+} // namespace Internal
+} // namespace Fossil
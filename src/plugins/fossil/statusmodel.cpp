@@ -0,0 +1,330 @@
+/**************************************************************************
+**  This file is part of Fossil VCS plugin for Qt Creator
+**
+**  Copyright (c) 2013 - 2020, Artur Shepilko, <qtc-fossil@nomadbyte.com>.
+**
+**  Based on Bazaar VCS plugin for Qt Creator by Hugues Delorme.
+**
+**  Permission is hereby granted, free of charge, to any person obtaining a copy
+**  of this software and associated documentation files (the "Software"), to deal
+**  in the Software without restriction, including without limitation the rights
+**  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+**  copies of the Software, and to permit persons to whom the Software is
+**  furnished to do so, subject to the following conditions:
+**
+**  The above copyright notice and this permission notice shall be included in
+**  all copies or substantial portions of the Software.
+**
+**  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+**  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+**  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+**  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+**  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+**  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+**  THE SOFTWARE.
+**************************************************************************/
+
+
+#include "statusmodel.h"
+#include "constants.h"
+#include "fossilclient.h"
+
+#include <utils/algorithm.h>
+#include <utils/qtcassert.h>
+
+#include <QDir>
+#include <QFileInfo>
+#include <QFutureWatcher>
+
+namespace Fossil {
+namespace Internal {
+
+// Delay to coalesce the bursts of change notifications
+const int refreshDelayMs = 300;
+// Refresh the whole check-out beyond this number of modified sub-trees
+const int maxPendingPaths = 32;
+// Limit the number of changed files watched per check-out
+const int maxWatchedFiles = 256;
+
+bool StatusModel::Checkout::isCurrent() const
+{
+    return hasSnapshot && !fullRefresh && !running && pendingPaths.isEmpty();
+}
+
+StatusModel::StatusModel(FossilClient *client, QObject *parent) : QObject(parent),
+    m_client(client)
+{
+    QTC_CHECK(m_client);
+
+    m_refreshTimer.setSingleShot(true);
+    m_refreshTimer.setInterval(refreshDelayMs);
+    connect(&m_refreshTimer, &QTimer::timeout, this, &StatusModel::refresh);
+    connect(&m_watcher, &QFileSystemWatcher::fileChanged, this, &StatusModel::fileChanged);
+}
+
+void StatusModel::watchCheckout(const QString &topLevel)
+{
+    if (topLevel.isEmpty() || topLevel == m_currentCheckout)
+        return;
+
+    const QString previousCheckout = m_currentCheckout;
+    m_currentCheckout = topLevel;
+    if (!previousCheckout.isEmpty() && !m_projectCheckouts.contains(previousCheckout))
+        removeCheckout(previousCheckout);
+
+    if (m_checkouts.contains(topLevel)) {
+        // The watch of a database removed meanwhile is dropped
+        const QString database = databaseFile(topLevel);
+        if (!m_watcher.files().contains(database) && QFileInfo(database).isFile()) {
+            m_watcher.addPath(database);
+            invalidate(topLevel);
+        }
+        return;
+    }
+
+    m_checkouts.insert(topLevel, Checkout());
+    m_watcher.addPath(databaseFile(topLevel));
+    m_refreshTimer.start();
+}
+
+void StatusModel::setProjectCheckouts(const QStringList &topLevels)
+{
+    m_projectCheckouts = topLevels;
+    const QStringList checkouts = m_checkouts.keys();
+    for (const QString &topLevel : checkouts) {
+        if (topLevel != m_currentCheckout && !m_projectCheckouts.contains(topLevel))
+            removeCheckout(topLevel);
+    }
+}
+
+void StatusModel::invalidate(const QString &topLevel)
+{
+    auto it = m_checkouts.find(topLevel);
+    if (it == m_checkouts.end())
+        return;
+
+    it->fullRefresh = true;
+    m_refreshTimer.start();
+}
+
+void StatusModel::invalidateChanged()
+{
+    // The edits made outside of the IDE are looked for in the current check-out only,
+    // the others are refreshed once fossil has updated their database.
+    bool modified = false;
+    for (auto it = m_checkouts.begin(), end = m_checkouts.end(); it != end; ++it) {
+        const QString database = databaseFile(it.key());
+        if (it.key() == m_currentCheckout
+                || QFileInfo(database).lastModified() != it->databaseModified) {
+            // Watched again, once the database is back
+            if (!m_watcher.files().contains(database) && QFileInfo(database).isFile())
+                m_watcher.addPath(database);
+            it->fullRefresh = true;
+            modified = true;
+        }
+    }
+    if (modified)
+        m_refreshTimer.start();
+}
+
+void StatusModel::invalidateFiles(const QStringList &files)
+{
+    bool modified = false;
+    for (const QString &file : files) {
+        const QString topLevel = topLevelForFile(file);
+        if (topLevel.isEmpty())
+            continue;
+
+        // Refresh the directory of the file, this also covers
+        // the deleted and renamed files
+        Checkout &checkout = m_checkouts[topLevel];
+        const QString path = QDir(topLevel).relativeFilePath(QFileInfo(file).absolutePath());
+        if (path == ".")
+            checkout.fullRefresh = true;
+        else
+            checkout.pendingPaths.insert(path);
+        modified = true;
+    }
+
+    if (modified)
+        m_refreshTimer.start();
+}
+
+Utils::optional<QList<StatusModel::StatusItem>> StatusModel::snapshot(const QString &topLevel) const
+{
+    const auto it = m_checkouts.constFind(topLevel);
+    if (it == m_checkouts.constEnd() || !it->isCurrent())
+        return Utils::nullopt;
+
+    return it->items.values();
+}
+
+QString StatusModel::topLevelForFile(const QString &file) const
+{
+    // Prefer the innermost of the nested check-outs
+    QString topLevel;
+    for (auto it = m_checkouts.cbegin(), end = m_checkouts.cend(); it != end; ++it) {
+        if (it.key().size() > topLevel.size() && file.startsWith(it.key() + '/'))
+            topLevel = it.key();
+    }
+    return topLevel;
+}
+
+QString StatusModel::databaseFile(const QString &topLevel)
+{
+    return topLevel + '/' + Constants::FOSSILREPO;
+}
+
+void StatusModel::removeCheckout(const QString &topLevel)
+{
+    if (m_checkouts.remove(topLevel) == 0)
+        return;
+
+    const QString prefix = topLevel + '/';
+    const QStringList watched = Utils::filtered(m_watcher.files(), [&prefix](const QString &file) {
+        return file.startsWith(prefix);
+    });
+    if (!watched.isEmpty())
+        m_watcher.removePaths(watched);
+}
+
+void StatusModel::fileChanged(const QString &file)
+{
+    // Files replaced on save drop out of the watch list
+    if (!m_watcher.files().contains(file) && QFileInfo::exists(file))
+        m_watcher.addPath(file);
+
+    if (!file.endsWith(Constants::FOSSILREPO)) {
+        invalidateFiles(QStringList(file));
+        return;
+    }
+
+    const QString topLevel = QFileInfo(file).absolutePath();
+    auto it = m_checkouts.find(topLevel);
+    if (it == m_checkouts.end())
+        return;
+
+    // Closed, the current check-out keeps its entry to be watched again
+    if (!QFileInfo(file).isFile()) {
+        if (topLevel == m_currentCheckout) {
+            it->hasSnapshot = false;
+            it->items.clear();
+        } else {
+            removeCheckout(topLevel);
+        }
+        return;
+    }
+
+    // Fossil updates the check-out database when scanning for changes,
+    // so skip the notifications caused by our own refresh.
+    if (it->running || QFileInfo(file).lastModified() == it->databaseModified)
+        return;
+
+    invalidate(topLevel);
+}
+
+void StatusModel::refresh()
+{
+    for (auto it = m_checkouts.begin(), end = m_checkouts.end(); it != end; ++it) {
+        Checkout &checkout = it.value();
+        if (!checkout.running && !checkout.isCurrent()
+                && (checkout.fullRefresh || !checkout.pendingPaths.isEmpty())) {
+            refreshCheckout(it.key(), checkout);
+        }
+    }
+}
+
+void StatusModel::refreshCheckout(const QString &topLevel, Checkout &checkout)
+{
+    QStringList paths;
+    if (!checkout.fullRefresh && checkout.hasSnapshot
+            && checkout.pendingPaths.size() <= maxPendingPaths
+            && m_client->supportedFeatures().testFlag(FossilClient::ChangesPathsFeature)) {
+        paths = checkout.pendingPaths.values();
+    }
+
+    checkout.fullRefresh = false;
+    checkout.pendingPaths.clear();
+    checkout.running = true;
+
+    auto watcher = new QFutureWatcher<QList<StatusItem>>(this);
+    connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher, topLevel, paths] {
+        watcher->deleteLater();
+
+        // Dropped meanwhile
+        auto it = m_checkouts.find(topLevel);
+        if (it == m_checkouts.end())
+            return;
+        it->running = false;
+        it->databaseModified = QFileInfo(databaseFile(topLevel)).lastModified();
+
+        const QFuture<QList<StatusItem>> future = watcher->future();
+        if (future.resultCount() > 0) {
+            applyStatus(topLevel, paths, future.result());
+        } else if (!paths.isEmpty()) {
+            // A partial refresh may fail on removed paths, retry in full
+            it->fullRefresh = true;
+        } else {
+            // Keep the snapshot stale until the next change
+            it->hasSnapshot = false;
+            return;
+        }
+
+        if (!it->isCurrent())
+            m_refreshTimer.start();
+    });
+    watcher->setFuture(m_client->statusQuery(topLevel, paths));
+}
+
+void StatusModel::applyStatus(const QString &topLevel, const QStringList &paths,
+                              const QList<StatusItem> &items)
+{
+    Checkout &checkout = m_checkouts[topLevel];
+
+    if (paths.isEmpty()) {
+        checkout.items.clear();
+    } else {
+        for (auto it = checkout.items.begin(); it != checkout.items.end(); ) {
+            const QString &file = it.key();
+            const bool affected = Utils::anyOf(paths, [&file](const QString &path) {
+                return file.startsWith(path + '/');
+            });
+            if (affected)
+                it = checkout.items.erase(it);
+            else
+                ++it;
+        }
+    }
+
+    for (const StatusItem &item : items)
+        checkout.items.insert(item.file, item);
+    checkout.hasSnapshot = true;
+
+    updateWatchedFiles(topLevel, checkout);
+    emit statusChanged(topLevel);
+}
+
+void StatusModel::updateWatchedFiles(const QString &topLevel, const Checkout &checkout)
+{
+    // Watch the changed files to notice when they are reverted
+    // or modified outside of the editor.
+    const QString prefix = topLevel + '/';
+    const QStringList watched = Utils::filtered(m_watcher.files(), [&prefix](const QString &file) {
+        return file.startsWith(prefix) && !file.endsWith(Constants::FOSSILREPO);
+    });
+    if (!watched.isEmpty())
+        m_watcher.removePaths(watched);
+
+    QStringList files;
+    for (auto it = checkout.items.cbegin(), end = checkout.items.cend();
+         it != end && files.size() < maxWatchedFiles; ++it) {
+        const QString file = prefix + it.key();
+        if (QFileInfo(file).isFile())
+            files.append(file);
+    }
+    if (!files.isEmpty())
+        m_watcher.addPaths(files);
+}
+
+} // namespace Internal
+} // namespace Fossil
@@ -0,0 +1,108 @@
+/**************************************************************************
+**  This file is part of Fossil VCS plugin for Qt Creator
+**
+**  Copyright (c) 2013 - 2020, Artur Shepilko, <qtc-fossil@nomadbyte.com>.
+**
+**  Based on Bazaar VCS plugin for Qt Creator by Hugues Delorme.
+**
+**  Permission is hereby granted, free of charge, to any person obtaining a copy
+**  of this software and associated documentation files (the "Software"), to deal
+**  in the Software without restriction, including without limitation the rights
+**  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+**  copies of the Software, and to permit persons to whom the Software is
+**  furnished to do so, subject to the following conditions:
+**
+**  The above copyright notice and this permission notice shall be included in
+**  all copies or substantial portions of the Software.
+**
+**  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+**  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+**  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+**  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+**  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+**  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+**  THE SOFTWARE.
+**************************************************************************/
+
+
+#pragma once
+
+#include <vcsbase/vcsbaseclient.h>
+
+#include <utils/optional.h>
+
+#include <QDateTime>
+#include <QFileSystemWatcher>
+#include <QHash>
+#include <QMap>
+#include <QObject>
+#include <QSet>
+#include <QTimer>
+
+namespace Fossil {
+namespace Internal {
+
+class FossilClient;
+
+// Per-checkout snapshot of the changed files.
+// The checkout database and the changed files are watched, the bursts of
+// change notifications are coalesced and only the affected sub-trees
+// are refreshed in the background. Only the current check-out and those
+// of the open projects are kept.
+
+class StatusModel : public QObject
+{
+    Q_OBJECT
+
+public:
+    using StatusItem = VcsBase::VcsBaseClient::StatusItem;
+
+    explicit StatusModel(FossilClient *client, QObject *parent = nullptr);
+
+    // Makes the check-out the current one, and watches it
+    void watchCheckout(const QString &topLevel);
+    // Drops the check-outs no longer current nor of an open project
+    void setProjectCheckouts(const QStringList &topLevels);
+    void invalidate(const QString &topLevel);
+    // On return to the IDE: the current check-out, and those whose database changed meanwhile
+    void invalidateChanged();
+    void invalidateFiles(const QStringList &files);
+
+    // Snapshot of the check-out status, if it is up to date
+    Utils::optional<QList<StatusItem>> snapshot(const QString &topLevel) const;
+
+signals:
+    void statusChanged(const QString &topLevel);
+
+private:
+    struct Checkout {
+        QMap<QString, StatusItem> items; // keyed by the path relative to the top-level
+        QSet<QString> pendingPaths;      // relative sub-trees to refresh
+        QDateTime databaseModified;      // as of the last refresh
+        bool hasSnapshot = false;
+        bool fullRefresh = true;
+        bool running = false;
+
+        bool isCurrent() const;
+    };
+
+    QString topLevelForFile(const QString &file) const;
+    static QString databaseFile(const QString &topLevel);
+    void removeCheckout(const QString &topLevel);
+    void fileChanged(const QString &file);
+    void refresh();
+    void refreshCheckout(const QString &topLevel, Checkout &checkout);
+    void applyStatus(const QString &topLevel, const QStringList &paths,
+                     const QList<StatusItem> &items);
+    void updateWatchedFiles(const QString &topLevel, const Checkout &checkout);
+
+    FossilClient *m_client;
+    QFileSystemWatcher m_watcher;
+    QTimer m_refreshTimer;
+    QHash<QString, Checkout> m_checkouts;
+    QString m_currentCheckout;
+    QStringList m_projectCheckouts;
+};
+
+} // namespace Internal
+} // namespace Fossil
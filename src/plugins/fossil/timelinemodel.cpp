@@ -0,0 +1,340 @@
+/**************************************************************************
+**  This file is part of Fossil VCS plugin for Qt Creator
+**
+**  Copyright (c) 2013 - 2020, Artur Shepilko, <qtc-fossil@nomadbyte.com>.
+**
+**  Based on Bazaar VCS plugin for Qt Creator by Hugues Delorme.
+**
+**  Permission is hereby granted, free of charge, to any person obtaining a copy
+**  of this software and associated documentation files (the "Software"), to deal
+**  in the Software without restriction, including without limitation the rights
+**  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+**  copies of the Software, and to permit persons to whom the Software is
+**  furnished to do so, subject to the following conditions:
+**
+**  The above copyright notice and this permission notice shall be included in
+**  all copies or substantial portions of the Software.
+**
+**  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+**  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+**  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+**  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+**  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+**  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+**  THE SOFTWARE.
+**************************************************************************/
+
+
+#include "timelinemodel.h"
+#include "fossilclient.h"
+#include "fossilsettings.h"
+
+#include <vcsbase/vcscommand.h>
+
+#include <utils/qtcassert.h>
+
+namespace Fossil {
+namespace Internal {
+
+// Number of timeline entries fetched at a time
+const int timelinePageSize = 250;
+
+void TimelineParser::addData(const QString &text)
+{
+    // Complete lines are parsed right away,
+    // the trailing partial line waits for the next chunk.
+    m_pendingLine.append(text);
+
+    int start = 0;
+    for (int end = m_pendingLine.indexOf('\n'); end >= 0; end = m_pendingLine.indexOf('\n', start)) {
+        int lineEnd = end;
+        if (lineEnd > start && m_pendingLine.at(lineEnd - 1) == '\r')
+            --lineEnd;
+        parseLine(m_pendingLine.mid(start, lineEnd - start));
+        start = end + 1;
+    }
+    m_pendingLine.remove(0, start);
+}
+
+void TimelineParser::finish()
+{
+    if (!m_pendingLine.isEmpty()) {
+        parseLine(m_pendingLine);
+        m_pendingLine.clear();
+    }
+    completeEntry();
+}
+
+void TimelineParser::reset()
+{
+    *this = TimelineParser();
+}
+
+QList<TimelineEntry> TimelineParser::takeEntries()
+{
+    QList<TimelineEntry> entries;
+    entries.swap(m_entries);
+    return entries;
+}
+
+bool TimelineParser::isAtEnd() const
+{
+    return m_atEnd;
+}
+
+void TimelineParser::parseLine(const QString &line)
+{
+    // Timeline format:
+    // "=== 2014-03-08 ==="
+    // "22:14:02 [ac6d1129b8] *BRANCH* Comment text. (user: ninja tags: trunk)"
+    // "   EDITED src/core/scaler.cpp"                 (verbose only)
+    // "                     wrapped comment text"     (legacy, no '-W 0')
+    // "--- line limit (250) reached ---"
+    // "+++ no more data (120) +++"
+
+    if (line.isEmpty())
+        return;
+
+    if (line.startsWith("=== ")) {
+        completeEntry();
+        m_date = line.mid(4, 10);
+        return;
+    }
+
+    if (line.startsWith("--- ") || line.startsWith("+++ ")) {
+        completeEntry();
+        if (line.startsWith("+++ "))
+            m_atEnd = true;
+        return;
+    }
+
+    const int size = line.size();
+    if (size > 11 && line.at(2) == ':' && line.at(5) == ':'
+            && line.at(8) == ' ' && line.at(9) == '[') {
+        const int idEnd = line.indexOf(']', 10);
+        if (idEnd > 10) {
+            completeEntry();
+            m_hasCurrent = true;
+            m_current.date = m_date;
+            m_current.time = line.left(8);
+            m_current.id = line.mid(10, idEnd - 10);
+            m_currentText = line.mid(idEnd + 1).trimmed();
+            return;
+        }
+    }
+
+    if (!m_hasCurrent)
+        return;
+
+    int indent = 0;
+    while (indent < size && line.at(indent) == ' ')
+        ++indent;
+
+    // Wrapped comments are aligned past the time-stamp and id
+    if (indent > 8 && m_current.files.isEmpty())
+        m_currentText.append(' ').append(line.midRef(indent));
+    else if (indent > 0 && indent < size)
+        m_current.files.append(line.mid(indent));
+}
+
+void TimelineParser::completeEntry()
+{
+    if (!m_hasCurrent)
+        return;
+
+    QString text = m_currentText;
+
+    // Leading markers: "*CURRENT* *MERGE* Comment text."
+    while (text.startsWith('*')) {
+        const int markerEnd = text.indexOf('*', 1);
+        if (markerEnd < 2)
+            break;
+        const QString marker = text.mid(1, markerEnd - 1);
+        if (marker.contains(' '))
+            break;
+        m_current.markers.append(marker);
+        text = text.mid(markerEnd + 1).trimmed();
+    }
+
+    // Trailing details: "(user: ninja tags: trunk, release)"
+    const int detailsStart = text.lastIndexOf(" (user: ");
+    if (detailsStart >= 0 && text.endsWith(')')) {
+        const QString details = text.mid(detailsStart + 8, text.size() - detailsStart - 9);
+        const int tagsStart = details.indexOf(" tags: ");
+        if (tagsStart >= 0) {
+            m_current.user = details.left(tagsStart).trimmed();
+            m_current.tags = details.mid(tagsStart + 7).split(", ", QString::SkipEmptyParts);
+        } else {
+            m_current.user = details.trimmed();
+        }
+        text.truncate(detailsStart);
+    }
+
+    m_current.comment = text.trimmed();
+    m_entries.append(m_current);
+
+    m_current = TimelineEntry();
+    m_currentText.clear();
+    m_hasCurrent = false;
+}
+
+
+TimelineModel::TimelineModel(FossilClient *client, QObject *parent) : QAbstractListModel(parent),
+    m_client(client)
+{
+    QTC_CHECK(m_client);
+}
+
+TimelineModel::~TimelineModel()
+{
+    cancelFetch();
+}
+
+void TimelineModel::setWorkingDirectory(const QString &workingDirectory)
+{
+    if (workingDirectory == m_workingDirectory)
+        return;
+
+    m_workingDirectory = workingDirectory;
+    refresh();
+}
+
+QString TimelineModel::workingDirectory() const
+{
+    return m_workingDirectory;
+}
+
+void TimelineModel::refresh()
+{
+    cancelFetch();
+
+    beginResetModel();
+    m_entries.clear();
+    m_ids.clear();
+    m_atEnd = m_workingDirectory.isEmpty();
+    endResetModel();
+}
+
+TimelineEntry TimelineModel::entry(int row) const
+{
+    return m_entries.value(row);
+}
+
+int TimelineModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_entries.size();
+}
+
+QVariant TimelineModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_entries.size())
+        return QVariant();
+
+    const TimelineEntry &entry = m_entries.at(index.row());
+
+    switch (role) {
+    case Qt::DisplayRole:
+        return QString("%1 %2 [%3] %4").arg(entry.date, entry.time, entry.id, entry.comment);
+    case Qt::ToolTipRole: {
+        QStringList lines;
+        lines << QString("%1 %2 [%3]").arg(entry.date, entry.time, entry.id);
+        if (!entry.user.isEmpty())
+            lines << tr("User: %1").arg(entry.user);
+        if (!entry.tags.isEmpty())
+            lines << tr("Tags: %1").arg(entry.tags.join(", "));
+        lines << QString() << entry.comment;
+        if (!entry.files.isEmpty())
+            lines << QString() << entry.files;
+        return lines.join('\n');
+    }
+    case IdRole:
+        return entry.id;
+    default:
+        break;
+    }
+    return QVariant();
+}
+
+bool TimelineModel::canFetchMore(const QModelIndex &parent) const
+{
+    return !parent.isValid() && !m_atEnd && !m_command;
+}
+
+void TimelineModel::fetchMore(const QModelIndex &parent)
+{
+    if (!canFetchMore(parent))
+        return;
+
+    // Continue from the oldest entry fetched so far. The anchor entry itself,
+    // and the ones sharing its time-stamp, are listed again and skipped.
+    QStringList args("timeline");
+    if (!m_entries.isEmpty())
+        args << "before" << m_entries.last().id;
+    args << "-n" << QString::number(timelinePageSize);
+    if (m_client->supportedFeatures().testFlag(FossilClient::TimelineWidthFeature))
+        args << "-W" << "0";
+    const QString itemType = m_client->settings().stringValue(FossilSettings::timelineItemTypeKey);
+    if (!itemType.isEmpty())
+        args << "-t" << itemType;
+
+    m_parser.reset();
+    m_pageEntryCount = 0;
+
+    m_command = m_client->createCommand(m_workingDirectory);
+    m_command->setProgressiveOutput(true);
+    connect(m_command.data(), &VcsBase::VcsCommand::stdOutText, this, &TimelineModel::addOutput);
+    connect(m_command.data(), &VcsBase::VcsCommand::finished, this, &TimelineModel::fetchFinished);
+    m_client->enqueueFossilJob(m_command.data(), args, JobScheduler::BackgroundRefresh, this);
+}
+
+void TimelineModel::cancelFetch()
+{
+    if (!m_command)
+        return;
+
+    // Drops the page fetch if it is still waiting, or cancels it
+    m_client->cancelJobs(this);
+    m_command.clear();
+}
+
+void TimelineModel::addOutput(const QString &text)
+{
+    m_parser.addData(text);
+    appendEntries(m_parser.takeEntries());
+}
+
+void TimelineModel::appendEntries(const QList<TimelineEntry> &entries)
+{
+    QList<TimelineEntry> newEntries;
+    for (const TimelineEntry &entry : entries) {
+        if (!m_ids.contains(entry.id))
+            newEntries.append(entry);
+    }
+    if (newEntries.isEmpty())
+        return;
+
+    beginInsertRows(QModelIndex(), m_entries.size(), m_entries.size() + newEntries.size() - 1);
+    for (const TimelineEntry &entry : qAsConst(newEntries)) {
+        m_ids.insert(entry.id);
+        m_entries.append(entry);
+    }
+    endInsertRows();
+
+    m_pageEntryCount += newEntries.size();
+}
+
+void TimelineModel::fetchFinished(bool ok)
+{
+    m_command.clear();
+
+    m_parser.finish();
+    appendEntries(m_parser.takeEntries());
+
+    // Stop on errors, at the end of the timeline, or when a page
+    // brought nothing new (all entries share the anchor's time-stamp)
+    if (!ok || m_parser.isAtEnd() || m_pageEntryCount == 0)
+        m_atEnd = true;
+}
+
+} // namespace Internal
+} // namespace Fossil
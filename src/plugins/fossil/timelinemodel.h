@@ -0,0 +1,128 @@
+/**************************************************************************
+**  This file is part of Fossil VCS plugin for Qt Creator
+**
+**  Copyright (c) 2013 - 2020, Artur Shepilko, <qtc-fossil@nomadbyte.com>.
+**
+**  Based on Bazaar VCS plugin for Qt Creator by Hugues Delorme.
+**
+**  Permission is hereby granted, free of charge, to any person obtaining a copy
+**  of this software and associated documentation files (the "Software"), to deal
+**  in the Software without restriction, including without limitation the rights
+**  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+**  copies of the Software, and to permit persons to whom the Software is
+**  furnished to do so, subject to the following conditions:
+**
+**  The above copyright notice and this permission notice shall be included in
+**  all copies or substantial portions of the Software.
+**
+**  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+**  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+**  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+**  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+**  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+**  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+**  THE SOFTWARE.
+**************************************************************************/
+
+
+#pragma once
+
+#include <QAbstractListModel>
+#include <QPointer>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+namespace VcsBase { class VcsCommand; }
+
+namespace Fossil {
+namespace Internal {
+
+class FossilClient;
+
+class TimelineEntry
+{
+public:
+    QString id;
+    QString date;          // "yyyy-MM-dd"
+    QString time;          // "hh:mm:ss"
+    QString user;
+    QStringList tags;
+    QStringList markers;   // e.g. CURRENT, MERGE, BRANCH
+    QString comment;
+    QStringList files;     // status lines, listed with verbose timeline only
+};
+
+// Incremental parser of 'fossil timeline' output.
+// Accepts the output in arbitrary chunks as it arrives,
+// an entry is complete once the next line after it is seen.
+
+class TimelineParser
+{
+public:
+    void addData(const QString &text);
+    void finish();
+    void reset();
+
+    QList<TimelineEntry> takeEntries();
+    bool isAtEnd() const;
+
+private:
+    void parseLine(const QString &line);
+    void completeEntry();
+
+    QString m_pendingLine;
+    QString m_date;
+    TimelineEntry m_current;
+    QString m_currentText;
+    bool m_hasCurrent = false;
+    bool m_atEnd = false;
+    QList<TimelineEntry> m_entries;
+};
+
+// List model of the repository timeline.
+// Fetches the timeline by pages on demand, so a view over it
+// only ever requests the entries it is about to show.
+
+class TimelineModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    enum Roles {
+        IdRole = Qt::UserRole + 1
+    };
+
+    explicit TimelineModel(FossilClient *client, QObject *parent = nullptr);
+    ~TimelineModel() override;
+
+    void setWorkingDirectory(const QString &workingDirectory);
+    QString workingDirectory() const;
+    void refresh();
+
+    TimelineEntry entry(int row) const;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
+
+private:
+    void cancelFetch();
+    void addOutput(const QString &text);
+    void appendEntries(const QList<TimelineEntry> &entries);
+    void fetchFinished(bool ok);
+
+    FossilClient *m_client;
+    QString m_workingDirectory;
+    QVector<TimelineEntry> m_entries;
+    QSet<QString> m_ids;
+    TimelineParser m_parser;
+    QPointer<VcsBase::VcsCommand> m_command;
+    int m_pageEntryCount = 0;
+    bool m_atEnd = true;
+};
+
+} // namespace Internal
+} // namespace Fossil
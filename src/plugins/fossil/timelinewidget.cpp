@@ -0,0 +1,110 @@
+/**************************************************************************
+**  This file is part of Fossil VCS plugin for Qt Creator
+**
+**  Copyright (c) 2013 - 2020, Artur Shepilko, <qtc-fossil@nomadbyte.com>.
+**
+**  Based on Bazaar VCS plugin for Qt Creator by Hugues Delorme.
+**
+**  Permission is hereby granted, free of charge, to any person obtaining a copy
+**  of this software and associated documentation files (the "Software"), to deal
+**  in the Software without restriction, including without limitation the rights
+**  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+**  copies of the Software, and to permit persons to whom the Software is
+**  furnished to do so, subject to the following conditions:
+**
+**  The above copyright notice and this permission notice shall be included in
+**  all copies or substantial portions of the Software.
+**
+**  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+**  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+**  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+**  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+**  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+**  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+**  THE SOFTWARE.
+**************************************************************************/
+
+
+#include "timelinewidget.h"
+#include "timelinemodel.h"
+
+#include <utils/utilsicons.h>
+
+#include <QListView>
+#include <QToolButton>
+#include <QVBoxLayout>
+
+namespace Fossil {
+namespace Internal {
+
+TimelineWidget::TimelineWidget(FossilClient *client, const TopLevelProvider &topLevelProvider,
+                               const DescribeHandler &describeHandler) :
+    m_topLevelProvider(topLevelProvider),
+    m_describeHandler(describeHandler),
+    m_model(new TimelineModel(client, this)),
+    m_view(new QListView(this)),
+    m_refreshButton(new QToolButton(this))
+{
+    // Uniform items let the view lay out only the visible rows,
+    // further pages are fetched when scrolled towards the end.
+    m_view->setUniformItemSizes(true);
+    m_view->setTextElideMode(Qt::ElideRight);
+    m_view->setFrameStyle(QFrame::NoFrame);
+    m_view->setModel(m_model);
+
+    auto layout = new QVBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->addWidget(m_view);
+
+    m_refreshButton->setIcon(Utils::Icons::RELOAD.icon());
+    m_refreshButton->setToolTip(tr("Refresh"));
+
+    connect(m_refreshButton, &QToolButton::clicked, this, &TimelineWidget::refresh);
+    connect(m_view, &QListView::activated, this, [this](const QModelIndex &index) {
+        const QString id = index.data(TimelineModel::IdRole).toString();
+        if (!id.isEmpty())
+            m_describeHandler(m_model->workingDirectory(), id);
+    });
+
+    refresh();
+}
+
+QToolButton *TimelineWidget::refreshButton() const
+{
+    return m_refreshButton;
+}
+
+void TimelineWidget::refresh()
+{
+    const QString topLevel = m_topLevelProvider();
+    if (topLevel == m_model->workingDirectory())
+        m_model->refresh();
+    else
+        m_model->setWorkingDirectory(topLevel);
+}
+
+
+TimelineNavigationWidgetFactory::TimelineNavigationWidgetFactory(
+        FossilClient *client, const TopLevelProvider &topLevelProvider,
+        const DescribeHandler &describeHandler) :
+    m_client(client),
+    m_topLevelProvider(topLevelProvider),
+    m_describeHandler(describeHandler)
+{
+    setDisplayName(tr("Fossil Timeline"));
+    setPriority(600);
+    setId("Fossil.Timeline");
+}
+
+Core::NavigationView TimelineNavigationWidgetFactory::createWidget()
+{
+    auto widget = new TimelineWidget(m_client, m_topLevelProvider, m_describeHandler);
+
+    Core::NavigationView view;
+    view.widget = widget;
+    view.dockToolBarWidgets << widget->refreshButton();
+    return view;
+}
+
+} // namespace Internal
+} // namespace Fossil
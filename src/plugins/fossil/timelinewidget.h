@@ -0,0 +1,88 @@
+/**************************************************************************
+**  This file is part of Fossil VCS plugin for Qt Creator
+**
+**  Copyright (c) 2013 - 2020, Artur Shepilko, <qtc-fossil@nomadbyte.com>.
+**
+**  Based on Bazaar VCS plugin for Qt Creator by Hugues Delorme.
+**
+**  Permission is hereby granted, free of charge, to any person obtaining a copy
+**  of this software and associated documentation files (the "Software"), to deal
+**  in the Software without restriction, including without limitation the rights
+**  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+**  copies of the Software, and to permit persons to whom the Software is
+**  furnished to do so, subject to the following conditions:
+**
+**  The above copyright notice and this permission notice shall be included in
+**  all copies or substantial portions of the Software.
+**
+**  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+**  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+**  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+**  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+**  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+**  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+**  THE SOFTWARE.
+**************************************************************************/
+
+
+#pragma once
+
+#include <coreplugin/inavigationwidgetfactory.h>
+
+#include <QWidget>
+
+#include <functional>
+
+QT_BEGIN_NAMESPACE
+class QListView;
+class QToolButton;
+QT_END_NAMESPACE
+
+namespace Fossil {
+namespace Internal {
+
+class FossilClient;
+class TimelineModel;
+
+using TopLevelProvider = std::function<QString()>;
+using DescribeHandler = std::function<void(const QString &source, const QString &id)>;
+
+// Timeline of the current repository, fetched page by page as it is scrolled.
+
+class TimelineWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    TimelineWidget(FossilClient *client, const TopLevelProvider &topLevelProvider,
+                   const DescribeHandler &describeHandler);
+
+    QToolButton *refreshButton() const;
+    void refresh();
+
+private:
+    const TopLevelProvider m_topLevelProvider;
+    const DescribeHandler m_describeHandler;
+    TimelineModel *m_model;
+    QListView *m_view;
+    QToolButton *m_refreshButton;
+};
+
+class TimelineNavigationWidgetFactory : public Core::INavigationWidgetFactory
+{
+    Q_OBJECT
+
+public:
+    TimelineNavigationWidgetFactory(FossilClient *client, const TopLevelProvider &topLevelProvider,
+                                    const DescribeHandler &describeHandler);
+
+    Core::NavigationView createWidget() final;
+
+private:
+    FossilClient *m_client;
+    const TopLevelProvider m_topLevelProvider;
+    const DescribeHandler m_describeHandler;
+};
+
+} // namespace Internal
+} // namespace Fossil
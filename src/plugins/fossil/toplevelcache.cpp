@@ -0,0 +1,145 @@
+/**************************************************************************
+**  This file is part of Fossil VCS plugin for Qt Creator
+**
+**  Copyright (c) 2013 - 2020, Artur Shepilko, <qtc-fossil@nomadbyte.com>.
+**
+**  Based on Bazaar VCS plugin for Qt Creator by Hugues Delorme.
+**
+**  Permission is hereby granted, free of charge, to any person obtaining a copy
+**  of this software and associated documentation files (the "Software"), to deal
+**  in the Software without restriction, including without limitation the rights
+**  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+**  copies of the Software, and to permit persons to whom the Software is
+**  furnished to do so, subject to the following conditions:
+**
+**  The above copyright notice and this permission notice shall be included in
+**  all copies or substantial portions of the Software.
+**
+**  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+**  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+**  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+**  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+**  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+**  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+**  THE SOFTWARE.
+**************************************************************************/
+
+
+#include "toplevelcache.h"
+#include "constants.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QStringList>
+
+namespace Fossil {
+namespace Internal {
+
+static bool isTopLevel(const QString &directory)
+{
+    // A directory of that name is no check-out
+    return QFileInfo(directory + '/' + Constants::FOSSILREPO).isFile();
+}
+
+static QString parentDirectory(const QString &directory)
+{
+    const int slash = directory.lastIndexOf('/');
+    if (slash < 0 || directory.size() == 1)
+        return QString();
+    // Keep the root of the file system as "/" or "C:/"
+    if (slash == 0 || (slash == 2 && directory.at(1) == ':'))
+        return slash + 1 == directory.size() ? QString() : directory.left(slash + 1);
+    return directory.left(slash);
+}
+
+TopLevelCache::TopLevelCache(int capacity) :
+    m_capacity(capacity)
+{ }
+
+QString TopLevelCache::find(const QString &directory)
+{
+    if (directory.isEmpty())
+        return QString();
+
+    const QString home = QDir::cleanPath(QDir::homePath());
+    const QString root = QDir::cleanPath(QDir::rootPath());
+
+    QMutexLocker locker(&m_mutex);
+
+    QStringList walked;
+    QString topLevel;
+    for (QString current = QDir::cleanPath(directory); !current.isEmpty();
+         current = parentDirectory(current)) {
+        if (current == home || current == root)
+            break;
+
+        const auto it = m_topLevels.constFind(current);
+        if (it != m_topLevels.constEnd()) {
+            // The check-out may have been closed, or opened in the directory since
+            if (it->topLevel.isEmpty()
+                    ? QFileInfo(current).lastModified() == it->modified
+                    : isTopLevel(it->topLevel)) {
+                topLevel = it->topLevel;
+                break;
+            }
+            const QString staleDirectory = it->topLevel.isEmpty() ? current : it->topLevel;
+            invalidateLocked(staleDirectory);
+        }
+
+        if (isTopLevel(current)) {
+            topLevel = current;
+            walked.append(current);
+            break;
+        }
+        walked.append(current);
+    }
+
+    if (m_topLevels.size() + walked.size() > m_capacity)
+        m_topLevels.clear();
+    for (const QString &path : walked) {
+        Entry entry;
+        entry.topLevel = topLevel;
+        if (topLevel.isEmpty())
+            entry.modified = QFileInfo(path).lastModified();
+        m_topLevels.insert(path, entry);
+    }
+
+    return topLevel;
+}
+
+void TopLevelCache::invalidate(const QString &directory)
+{
+    QMutexLocker locker(&m_mutex);
+    invalidateLocked(QDir::cleanPath(directory));
+}
+
+void TopLevelCache::clearUnmanaged()
+{
+    QMutexLocker locker(&m_mutex);
+    for (auto it = m_topLevels.begin(); it != m_topLevels.end(); ) {
+        if (it->topLevel.isEmpty())
+            it = m_topLevels.erase(it);
+        else
+            ++it;
+    }
+}
+
+void TopLevelCache::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_topLevels.clear();
+}
+
+void TopLevelCache::invalidateLocked(const QString &directory)
+{
+    // Drop the directory and its sub-tree, these may map to a different top-level now.
+    // The ancestors are not affected, as they are not inside of the check-out.
+    const QString prefix = directory.endsWith('/') ? directory : directory + '/';
+    m_topLevels.remove(directory);
+    auto it = m_topLevels.lowerBound(prefix);
+    while (it != m_topLevels.end() && it.key().startsWith(prefix))
+        it = m_topLevels.erase(it);
+}
+
+} // namespace Internal
+} // namespace Fossil
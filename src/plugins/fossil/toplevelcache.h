@@ -0,0 +1,73 @@
+/**************************************************************************
+**  This file is part of Fossil VCS plugin for Qt Creator
+**
+**  Copyright (c) 2013 - 2020, Artur Shepilko, <qtc-fossil@nomadbyte.com>.
+**
+**  Based on Bazaar VCS plugin for Qt Creator by Hugues Delorme.
+**
+**  Permission is hereby granted, free of charge, to any person obtaining a copy
+**  of this software and associated documentation files (the "Software"), to deal
+**  in the Software without restriction, including without limitation the rights
+**  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+**  copies of the Software, and to permit persons to whom the Software is
+**  furnished to do so, subject to the following conditions:
+**
+**  The above copyright notice and this permission notice shall be included in
+**  all copies or substantial portions of the Software.
+**
+**  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+**  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+**  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+**  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+**  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+**  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+**  THE SOFTWARE.
+**************************************************************************/
+
+
+#pragma once
+
+#include <QDateTime>
+#include <QMap>
+#include <QMutex>
+#include <QString>
+
+namespace Fossil {
+namespace Internal {
+
+// Maps directories to the top-level of the check-out containing them,
+// with an empty top-level cached for the unmanaged directories.
+// The lookup walks up the directory tree only until a cached ancestor,
+// and caches the result for each of the directories walked. As in
+// VcsBase::findRepositoryForDirectory(), the walk stops short of the home
+// directory and the root of the file system. An unmanaged directory is
+// looked up again once it is modified, or after clearUnmanaged().
+// Thread-safe, lookups may come from the query pool.
+
+class TopLevelCache
+{
+public:
+    explicit TopLevelCache(int capacity = 4096);
+
+    QString find(const QString &directory);
+    // A check-out was created or removed at or below the directory
+    void invalidate(const QString &directory);
+    // A check-out may have been opened outside of the IDE
+    void clearUnmanaged();
+    void clear();
+
+private:
+    struct Entry {
+        QString topLevel;
+        QDateTime modified;     // of the unmanaged directory, when looked up
+    };
+
+    void invalidateLocked(const QString &directory);
+
+    const int m_capacity;
+    QMutex m_mutex;
+    QMap<QString, Entry> m_topLevels; // sorted, so a sub-tree is a contiguous range
+};
+
+} // namespace Internal
+} // namespace Fossil
@@ -0,0 +1,8 @@
+TEMPLATE = app
+TARGET = fossil_fixturegen
+
+QT = core
+CONFIG += console
+CONFIG -= app_bundle
+
+SOURCES += main.cpp
@@ -0,0 +1,437 @@
+/**************************************************************************
+**  This file is part of Fossil VCS plugin for Qt Creator
+**
+**  Copyright (c) 2013 - 2020, Artur Shepilko, <qtc-fossil@nomadbyte.com>.
+**
+**  Based on Bazaar VCS plugin for Qt Creator by Hugues Delorme.
+**
+**  Permission is hereby granted, free of charge, to any person obtaining a copy
+**  of this software and associated documentation files (the "Software"), to deal
+**  in the Software without restriction, including without limitation the rights
+**  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+**  copies of the Software, and to permit persons to whom the Software is
+**  furnished to do so, subject to the following conditions:
+**
+**  The above copyright notice and this permission notice shall be included in
+**  all copies or substantial portions of the Software.
+**
+**  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+**  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+**  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+**  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+**  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+**  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+**  THE SOFTWARE.
+**************************************************************************/
+
+
+// Generates fossil repositories of a controlled shape for the performance
+// fixtures. Uses the local fossil binary only, no network access.
+// The history is derived from the seed alone: the check-in dates and users
+// are overridden, so the same options reproduce the same check-in hashes.
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QProcess>
+#include <QTextStream>
+
+#include <random>
+
+namespace {
+
+struct Options
+{
+    QString fossil = "fossil";
+    QString output;
+    QString record;
+    quint32 seed = 1;
+    int checkins = 20;
+    int files = 10;
+    int branches = 2;
+    int tags = 2;
+    int mergeInterval = 5;
+    qint64 hugeFileSize = 0;
+};
+
+class Generator
+{
+public:
+    explicit Generator(const Options &options);
+
+    bool run();
+
+private:
+    bool fossil(const QStringList &args, QByteArray *output = nullptr, bool reportErrors = true);
+    bool commit(const QString &comment, const QStringList &extraArgs = QStringList());
+    bool createBranch(int branch);
+    bool mergeBranch();
+    bool tag(int tag);
+    bool leaveChanges();
+    bool record();
+
+    int random(int bound);
+    QString nextDate();
+    QString fileName(int file) const;
+    void writeFile(const QString &name, int lineCount);
+    void editFile(const QString &name);
+    void writeHugeFile();
+
+    const Options m_options;
+    std::mt19937 m_random;
+    QDir m_checkout;
+    QString m_repository;
+    QString m_homeDir;
+    QDateTime m_date;
+    QStringList m_branchNames;
+    QString m_currentBranch = "trunk";
+    int m_checkinCount = 0;
+};
+
+Generator::Generator(const Options &options) :
+    m_options(options),
+    m_random(options.seed),
+    m_date(QDate(2020, 1, 1), QTime(0, 0), Qt::UTC)
+{ }
+
+bool Generator::run()
+{
+    QDir output(m_options.output);
+    if (!output.mkpath("checkout") || !output.mkpath("home")) {
+        qCritical("Cannot create the output directory \"%s\".", qPrintable(m_options.output));
+        return false;
+    }
+    m_checkout.setPath(output.absoluteFilePath("checkout"));
+    m_homeDir = output.absoluteFilePath("home");
+    m_repository = output.absoluteFilePath("fixture.fossil");
+    if (QFile::exists(m_repository)) {
+        qCritical("Repository \"%s\" already exists.", qPrintable(m_repository));
+        return false;
+    }
+
+    if (!fossil({"init", "--date-override", nextDate(), "--admin-user", "fixture", m_repository})
+            || !fossil({"open", m_repository})
+            || !fossil({"settings", "autosync", "off"})) {
+        return false;
+    }
+
+    for (int file = 0; file < m_options.files; ++file)
+        writeFile(fileName(file), 20 + random(80));
+    if (m_options.hugeFileSize > 0)
+        writeHugeFile();
+    if (!fossil({"add", "."}) || !commit("Initial import"))
+        return false;
+
+    const int branchInterval = m_options.branches > 0
+            ? qMax(1, m_options.checkins / (m_options.branches + 1)) : 0;
+    const int tagInterval = m_options.tags > 0
+            ? qMax(1, m_options.checkins / m_options.tags) : 0;
+    int branch = 0;
+    int tagNumber = 0;
+
+    while (m_checkinCount < m_options.checkins) {
+        const int step = m_checkinCount;
+        if (branchInterval && branch < m_options.branches && step > 0 && step % branchInterval == 0) {
+            if (!createBranch(branch++))
+                return false;
+        } else if (m_options.mergeInterval > 0 && !m_branchNames.isEmpty()
+                   && step % m_options.mergeInterval == 0) {
+            if (!mergeBranch())
+                return false;
+        } else {
+            const int editCount = 1 + random(qMin(5, qMax(1, m_options.files)));
+            for (int i = 0; i < editCount; ++i)
+                editFile(fileName(random(m_options.files)));
+            if (m_options.hugeFileSize > 0 && random(100) == 0)
+                writeHugeFile();
+            if (!commit(QString("Change %1 on %2").arg(step).arg(m_currentBranch)))
+                return false;
+        }
+
+        if (tagInterval && tagNumber < m_options.tags && m_checkinCount % tagInterval == 0) {
+            if (!tag(tagNumber++))
+                return false;
+        }
+    }
+
+    if (!leaveChanges())
+        return false;
+
+    return m_options.record.isEmpty() || record();
+}
+
+bool Generator::fossil(const QStringList &args, QByteArray *output, bool reportErrors)
+{
+    // Keep the global fossil settings of the user out of the way
+    QProcessEnvironment environment = QProcessEnvironment::systemEnvironment();
+    environment.insert("HOME", m_homeDir);
+    environment.insert("FOSSIL_HOME", m_homeDir);
+    environment.insert("FOSSIL_USER", "fixture");
+
+    QProcess process;
+    process.setProcessEnvironment(environment);
+    process.setWorkingDirectory(m_checkout.absolutePath());
+    process.start(m_options.fossil, args);
+    // Answer any interactive prompt with end of input
+    process.closeWriteChannel();
+    if (!process.waitForFinished(-1) || process.exitStatus() != QProcess::NormalExit
+            || process.exitCode() != 0) {
+        if (reportErrors) {
+            qCritical("fossil %s failed: %s", qPrintable(args.join(' ')),
+                      process.readAllStandardError().constData());
+        }
+        return false;
+    }
+
+    if (output)
+        *output = process.readAllStandardOutput();
+    return true;
+}
+
+bool Generator::commit(const QString &comment, const QStringList &extraArgs)
+{
+    QStringList args({"commit", "--no-warnings", "--allow-conflict",
+                      "--date-override", nextDate(),
+                      "--user-override", QString("user%1").arg(random(8)),
+                      "-m", comment});
+    args << extraArgs;
+    if (!fossil(args))
+        return false;
+
+    ++m_checkinCount;
+    return true;
+}
+
+bool Generator::createBranch(int branch)
+{
+    // Fork off the current branch, every branch starts with a commit of its own
+    const QString branchName = QString("branch-%1").arg(branch);
+    editFile(fileName(random(m_options.files)));
+    if (!commit(QString("Start %1").arg(branchName), {"--branch", branchName}))
+        return false;
+
+    m_branchNames.append(branchName);
+    m_currentBranch = branchName;
+    return true;
+}
+
+bool Generator::mergeBranch()
+{
+    // Merge another branch into a randomly chosen one,
+    // switching between the branches builds up the merge graph.
+    QStringList branches = m_branchNames;
+    branches.prepend("trunk");
+
+    const QString target = branches.at(random(branches.size()));
+    branches.removeOne(target);
+    const QString source = branches.at(random(branches.size()));
+
+    if (target != m_currentBranch) {
+        if (!fossil({"update", target}))
+            return false;
+        m_currentBranch = target;
+    }
+
+    // Nothing is left to merge when the source is already an ancestor,
+    // the edit keeps the check-in non-empty either way.
+    fossil({"merge", source}, nullptr, false);
+    editFile(fileName(random(m_options.files)));
+    return commit(QString("Merge %1 into %2").arg(source, target));
+}
+
+bool Generator::tag(int tag)
+{
+    return fossil({"tag", "add", "--date-override", nextDate(), "--user-override", "fixture",
+                   QString("release-%1").arg(tag), "current"});
+}
+
+bool Generator::leaveChanges()
+{
+    // Uncommitted changes for the status outputs
+    for (int i = 0; i < qMin(5, m_options.files); ++i)
+        editFile(fileName(random(m_options.files)));
+
+    writeFile("added.txt", 10);
+    if (!fossil({"add", "added.txt"}))
+        return false;
+
+    return m_options.files < 2 || fossil({"rm", fileName(m_options.files - 1)});
+}
+
+bool Generator::record()
+{
+    // Outputs of the commands parsed by the plugin, named after the command
+    const QList<QPair<QString, QStringList>> commands = {
+        {"changes.txt", {"changes"}},
+        {"status.txt", {"status"}},
+        {"branch-list.txt", {"branch", "list", "--all"}},
+        {"timeline.txt", {"timeline", "-n", "0", "-v", "-W", "0", "-t", "ci"}},
+        {"info.txt", {"info", "current"}},
+        {"annotate.txt", {"annotate", fileName(0)}},
+        {"diff.txt", {"diff"}}
+    };
+
+    QDir recordDir(m_options.record);
+    if (!recordDir.mkpath(".")) {
+        qCritical("Cannot create the record directory \"%s\".", qPrintable(m_options.record));
+        return false;
+    }
+
+    for (const QPair<QString, QStringList> &command : commands) {
+        QByteArray output;
+        if (!fossil(command.second, &output))
+            return false;
+
+        QFile file(recordDir.absoluteFilePath(command.first));
+        if (!file.open(QIODevice::WriteOnly) || file.write(output) != output.size()) {
+            qCritical("Cannot write \"%s\".", qPrintable(file.fileName()));
+            return false;
+        }
+    }
+
+    QFile info(recordDir.absoluteFilePath("fixture.txt"));
+    if (!info.open(QIODevice::WriteOnly | QIODevice::Text))
+        return false;
+    QTextStream(&info) << "seed: " << m_options.seed << '\n'
+                       << "checkins: " << m_options.checkins << '\n'
+                       << "files: " << m_options.files << '\n'
+                       << "branches: " << m_options.branches << '\n'
+                       << "tags: " << m_options.tags << '\n'
+                       << "merge-interval: " << m_options.mergeInterval << '\n'
+                       << "huge-file-size: " << m_options.hugeFileSize << '\n';
+    return true;
+}
+
+int Generator::random(int bound)
+{
+    // Distributions are implementation-defined, keep to the engine itself
+    return bound > 0 ? int(m_random() % quint32(bound)) : 0;
+}
+
+QString Generator::nextDate()
+{
+    m_date = m_date.addSecs(600 + random(7200));
+    return m_date.toString("yyyy-MM-ddTHH:mm:ss");
+}
+
+QString Generator::fileName(int file) const
+{
+    return QString("src/module%1/file%2.txt").arg(file % 16).arg(file);
+}
+
+void Generator::writeFile(const QString &name, int lineCount)
+{
+    m_checkout.mkpath(QFileInfo(name).path());
+    QFile file(m_checkout.absoluteFilePath(name));
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+        return;
+
+    QTextStream stream(&file);
+    for (int line = 0; line < lineCount; ++line)
+        stream << "line " << line << " value " << m_random() << '\n';
+}
+
+void Generator::editFile(const QString &name)
+{
+    // Replace one line and insert another one
+    QFile file(m_checkout.absoluteFilePath(name));
+    if (!file.open(QIODevice::ReadWrite | QIODevice::Text))
+        return;
+
+    QList<QByteArray> lines = file.readAll().split('\n');
+    if (!lines.isEmpty() && lines.last().isEmpty())
+        lines.removeLast();
+    if (!lines.isEmpty())
+        lines[random(lines.size())] = "edited value " + QByteArray::number(m_random());
+    lines.insert(random(lines.size() + 1), "inserted value " + QByteArray::number(m_random()));
+
+    file.resize(0);
+    file.write(lines.join('\n') + '\n');
+}
+
+void Generator::writeHugeFile()
+{
+    m_checkout.mkpath("huge");
+    QFile file(m_checkout.absoluteFilePath("huge/data.txt"));
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+        return;
+
+    QByteArray line;
+    for (qint64 size = 0; size < m_options.hugeFileSize; size += line.size()) {
+        line = "data " + QByteArray::number(m_random()) + ' ' + QByteArray::number(m_random()) + '\n';
+        file.write(line);
+    }
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("fossil_fixturegen");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Generates fossil repositories for the performance fixtures.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("output", "Directory to create the repository and check-out in.");
+
+    const QCommandLineOption presetOption("preset", "Repository shape: small, medium or huge.", "preset");
+    const QCommandLineOption fossilOption("fossil", "The fossil binary to use.", "path", "fossil");
+    const QCommandLineOption recordOption("record", "Record the command outputs into the directory.", "dir");
+    const QCommandLineOption seedOption("seed", "Seed of the generated history.", "n", "1");
+    const QCommandLineOption checkinsOption("checkins", "Number of check-ins.", "n");
+    const QCommandLineOption filesOption("files", "Number of files.", "n");
+    const QCommandLineOption branchesOption("branches", "Number of branches.", "n");
+    const QCommandLineOption tagsOption("tags", "Number of tags.", "n");
+    const QCommandLineOption mergeOption("merge-interval", "Merge branches every n check-ins, 0 for none.", "n");
+    const QCommandLineOption hugeOption("huge-file-size", "Size in bytes of a huge file, 0 for none.", "bytes");
+    parser.addOptions({presetOption, fossilOption, recordOption, seedOption, checkinsOption,
+                       filesOption, branchesOption, tagsOption, mergeOption, hugeOption});
+    parser.process(app);
+
+    if (parser.positionalArguments().size() != 1)
+        parser.showHelp(1);
+
+    Options options;
+    const QString preset = parser.value(presetOption);
+    if (preset == "medium") {
+        options.checkins = 1000;
+        options.files = 200;
+        options.branches = 10;
+        options.tags = 20;
+        options.mergeInterval = 10;
+        options.hugeFileSize = 1 << 20;
+    } else if (preset == "huge") {
+        options.checkins = 10000;
+        options.files = 2000;
+        options.branches = 50;
+        options.tags = 100;
+        options.mergeInterval = 20;
+        options.hugeFileSize = 32 << 20;
+    } else if (!preset.isEmpty() && preset != "small") {
+        qCritical("Unknown preset \"%s\".", qPrintable(preset));
+        return 1;
+    }
+
+    options.output = parser.positionalArguments().first();
+    options.fossil = parser.value(fossilOption);
+    options.record = parser.value(recordOption);
+    options.seed = parser.value(seedOption).toUInt();
+    if (parser.isSet(checkinsOption))
+        options.checkins = parser.value(checkinsOption).toInt();
+    if (parser.isSet(filesOption))
+        options.files = qMax(1, parser.value(filesOption).toInt());
+    if (parser.isSet(branchesOption))
+        options.branches = parser.value(branchesOption).toInt();
+    if (parser.isSet(tagsOption))
+        options.tags = parser.value(tagsOption).toInt();
+    if (parser.isSet(mergeOption))
+        options.mergeInterval = parser.value(mergeOption).toInt();
+    if (parser.isSet(hugeOption))
+        options.hugeFileSize = parser.value(hugeOption).toLongLong();
+
+    Generator generator(options);
+    return generator.run() ? 0 : 1;
+}
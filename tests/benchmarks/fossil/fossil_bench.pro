@@ -0,0 +1,26 @@
+QTC_LIB_DEPENDS += utils
+QTC_PLUGIN_DEPENDS += coreplugin texteditor vcsbase
+
+include(../../auto/qttest.pri)
+
+QT += widgets
+
+TARGET = fossil_bench
+
+FOSSIL_DIR = $$IDE_SOURCE_TREE/src/plugins/fossil
+INCLUDEPATH += $$FOSSIL_DIR
+
+SOURCES += \
+    tst_fossil_bench.cpp \
+    $$FOSSIL_DIR/annotationhighlighter.cpp \
+    $$FOSSIL_DIR/branchinfo.cpp \
+    $$FOSSIL_DIR/loghighlighter.cpp \
+    $$FOSSIL_DIR/outputparser.cpp \
+    $$FOSSIL_DIR/revisioninfo.cpp
+HEADERS += \
+    $$FOSSIL_DIR/annotationhighlighter.h \
+    $$FOSSIL_DIR/branchinfo.h \
+    $$FOSSIL_DIR/constants.h \
+    $$FOSSIL_DIR/loghighlighter.h \
+    $$FOSSIL_DIR/outputparser.h \
+    $$FOSSIL_DIR/revisioninfo.h
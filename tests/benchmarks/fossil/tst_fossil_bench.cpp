@@ -0,0 +1,399 @@
+/**************************************************************************
+**  This file is part of Fossil VCS plugin for Qt Creator
+**
+**  Copyright (c) 2013 - 2020, Artur Shepilko, <qtc-fossil@nomadbyte.com>.
+**
+**  Based on Bazaar VCS plugin for Qt Creator by Hugues Delorme.
+**
+**  Permission is hereby granted, free of charge, to any person obtaining a copy
+**  of this software and associated documentation files (the "Software"), to deal
+**  in the Software without restriction, including without limitation the rights
+**  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+**  copies of the Software, and to permit persons to whom the Software is
+**  furnished to do so, subject to the following conditions:
+**
+**  The above copyright notice and this permission notice shall be included in
+**  all copies or substantial portions of the Software.
+**
+**  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+**  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+**  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+**  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+**  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+**  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+**  THE SOFTWARE.
+**************************************************************************/
+
+
+#include "annotationhighlighter.h"
+#include "loghighlighter.h"
+#include "outputparser.h"
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTextDocument>
+#include <QtTest>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// Allocation counting.
+// With glibc all heap allocations, including those of Qt containers,
+// go through malloc, so interpose it; elsewhere count operator new only.
+
+static std::atomic<bool> g_countAllocations(false);
+static std::atomic<qint64> g_allocationCount(0);
+
+static inline void countAllocation()
+{
+    if (g_countAllocations.load(std::memory_order_relaxed))
+        g_allocationCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+#if defined(__GLIBC__)
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+
+void *malloc(size_t size) noexcept
+{
+    countAllocation();
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) noexcept
+{
+    countAllocation();
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size) noexcept
+{
+    countAllocation();
+    return __libc_realloc(ptr, size);
+}
+} // extern "C"
+#else
+void *operator new(std::size_t size)
+{
+    countAllocation();
+    if (void *ptr = std::malloc(size ? size : 1))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+#endif
+
+using namespace Fossil::Internal;
+
+// Outputs recorded from the generated repositories (see fixturegen),
+// with FOSSIL_FIXTURES_DIR pointing to the directory that holds
+// the "small", "medium" and "huge" records.
+
+static QString recordedOutput(const QString &fixtureDir, const QString &fileName)
+{
+    if (fixtureDir.isEmpty())
+        return QString();
+
+    QFile file(QDir(fixtureDir).absoluteFilePath(fileName));
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return QString();
+    return QString::fromUtf8(file.readAll());
+}
+
+static QStringList recordedLines(const QString &fixtureDir, const QString &fileName)
+{
+    return recordedOutput(fixtureDir, fileName).split('\n', QString::SkipEmptyParts);
+}
+
+// Synthetic outputs, shaped after the respective fossil commands,
+// used in the absence of the recorded ones
+
+static QStringList statusLines(int count)
+{
+    static const char *labels[] = {"EDITED", "ADDED", "DELETED", "RENAMED", "MISSING",
+                                   "UPDATED_BY_MERGE", "CONFLICT", "EXECUTABLE"};
+    QStringList lines;
+    lines.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        lines << QString("%1 src/module%2/file%3.cpp")
+                 .arg(QString::fromLatin1(labels[i % 8]), -17).arg(i % 97).arg(i);
+    }
+    return lines;
+}
+
+static QString branchListOutput(int count)
+{
+    QString output;
+    for (int i = 0; i < count; ++i) {
+        if (i == count / 2)
+            output += "* trunk\n";
+        else if (i % 10 == 0)
+            output += QString("#  private-%1\n").arg(i);
+        else
+            output += QString("   branch-%1\n").arg(i);
+    }
+    return output;
+}
+
+static QByteArray commentLines(int count)
+{
+    QByteArray output;
+    for (int i = 0; i < count; ++i) {
+        output += QString("comment:      Fix the (handling) of case %1 in module %2 (user: user%3)\n")
+                  .arg(i).arg(i % 97).arg(i % 13).toUtf8();
+    }
+    return output;
+}
+
+static QString revisionInfoOutput()
+{
+    return QString(
+        "project-name: Fossil Plugin\n"
+        "repository:   /home/user/repos/plugin.fossil\n"
+        "local-root:   /home/user/src/plugin/\n"
+        "config-db:    /home/user/.fossil\n"
+        "checkout:     7f4f7a0f8dbc2b1c7a3f7dcb0ce8b5e5c6a0e8d1e2f3a4b5c6d7e8f9a0b1c2d3 2020-03-05 14:22:33 UTC\n"
+        "parent:       0a1b2c3d4e5f60718293a4b5c6d7e8f90a1b2c3d4e5f60718293a4b5c6d7e8f9 2020-03-04 10:01:02 UTC\n"
+        "merged-from:  6e7f8a9b0c1d2e3f4a5b6c7d8e9f0a1b2c3d4e5f6a7b8c9d0e1f2a3b4c5d6e7f 2020-03-03 09:00:00 UTC\n"
+        "tags:         trunk, release\n"
+        "comment:      Merge the (pending) fixes from the release branch (user: user1)\n"
+        "check-ins:    12345\n");
+}
+
+static QString timelineOutput(int count)
+{
+    QString output;
+    for (int i = 0; i < count; ++i) {
+        if (i % 20 == 0)
+            output += QString("=== 2020-%1-%2 ===\n").arg(1 + i / 20 % 12, 2, 10, QChar('0'))
+                                                     .arg(1 + i / 20 % 28, 2, 10, QChar('0'));
+        output += QString("12:%1:%2 [%3] Change number %4 to the module. (user: user%5 tags: trunk)\n")
+                .arg(i / 60 % 60, 2, 10, QChar('0')).arg(i % 60, 2, 10, QChar('0'))
+                .arg(quint64(0x1000000000ULL + quint64(i) * 7919), 10, 16, QChar('0'))
+                .arg(i).arg(i % 13);
+        output += QString("   EDITED src/module%1/file%2.cpp\n").arg(i % 97).arg(i);
+    }
+    return output;
+}
+
+static QString annotateOutput(int count, VcsBase::BaseAnnotationHighlighter::ChangeNumbers *changes)
+{
+    QString output;
+    for (int i = 0; i < count; ++i) {
+        const QString id = QString("%1").arg(quint64(0x1000000000ULL + quint64(i % 64) * 7919),
+                                             10, 16, QChar('0'));
+        changes->insert(id);
+        output += QString("%1 2020-03-%2     user%3: int value%4 = compute(%4); // line %4\n")
+                .arg(id).arg(1 + i % 28, 2, 10, QChar('0')).arg(i % 13).arg(i);
+    }
+    return output;
+}
+
+// Runs the function once more outside of QBENCHMARK to report per line figures
+template <typename Function>
+static void reportPerLine(int lineCount, const Function &function)
+{
+    g_allocationCount.store(0);
+    g_countAllocations.store(true);
+    QElapsedTimer timer;
+    timer.start();
+    function();
+    const qint64 elapsedNs = timer.nsecsElapsed();
+    g_countAllocations.store(false);
+
+    qInfo("%s/%s: %.1f ns/line, %.2f allocations/line",
+          QTest::currentTestFunction(), QTest::currentDataTag(),
+          double(elapsedNs) / lineCount, double(g_allocationCount.load()) / lineCount);
+}
+
+class tst_FossilBench : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void parseStatusLine_data() { addSizes(); }
+    void parseStatusLine();
+    void parseStatus_data() { addSizes(); }
+    void parseStatus();
+    void parseBranchList_data() { addSizes(); }
+    void parseBranchList();
+    void parseRevisionCommentLine_data() { addSizes(); }
+    void parseRevisionCommentLine();
+    void parseRevisionInfo_data() { addSizes(); }
+    void parseRevisionInfo();
+    void logHighlighter_data() { addSizes(); }
+    void logHighlighter();
+    void annotationHighlighter_data() { addSizes(); }
+    void annotationHighlighter();
+
+private:
+    static void addSizes();
+};
+
+void tst_FossilBench::addSizes()
+{
+    QTest::addColumn<int>("lineCount");
+    QTest::addColumn<QString>("fixtureDir");
+
+    const QString fixturesDir = qEnvironmentVariable("FOSSIL_FIXTURES_DIR");
+    const auto fixtureDir = [&fixturesDir](const char *name) {
+        return fixturesDir.isEmpty() ? QString() : QDir(fixturesDir).absoluteFilePath(name);
+    };
+
+    QTest::newRow("small") << 100 << fixtureDir("small");
+    QTest::newRow("medium") << 10000 << fixtureDir("medium");
+    QTest::newRow("huge") << 200000 << fixtureDir("huge");
+}
+
+void tst_FossilBench::parseStatusLine()
+{
+    QFETCH(int, lineCount);
+    QFETCH(QString, fixtureDir);
+    QStringList lines = recordedLines(fixtureDir, "changes.txt");
+    if (lines.isEmpty())
+        lines = statusLines(lineCount);
+    lineCount = lines.size();
+
+    const auto run = [&lines] {
+        for (const QString &line : lines)
+            QVERIFY(!OutputParser::parseStatusLine(line).file.isEmpty());
+    };
+    QBENCHMARK { run(); }
+    reportPerLine(lineCount, run);
+}
+
+void tst_FossilBench::parseStatus()
+{
+    QFETCH(int, lineCount);
+    QFETCH(QString, fixtureDir);
+    QStringList lines = recordedLines(fixtureDir, "changes.txt");
+    if (lines.isEmpty())
+        lines = statusLines(lineCount);
+    lineCount = lines.size();
+    const QByteArray output = lines.join('\n').toUtf8();
+
+    const auto run = [&output, lineCount] {
+        QCOMPARE(OutputParser::parseStatus(output).size(), lineCount);
+    };
+    QBENCHMARK { run(); }
+    reportPerLine(lineCount, run);
+}
+
+void tst_FossilBench::parseBranchList()
+{
+    QFETCH(int, lineCount);
+    QFETCH(QString, fixtureDir);
+    QString output = recordedOutput(fixtureDir, "branch-list.txt");
+    if (output.isEmpty())
+        output = branchListOutput(lineCount);
+    lineCount = output.count('\n');
+
+    const auto run = [&output, lineCount] {
+        QCOMPARE(OutputParser::parseBranchList(output).size(), lineCount);
+    };
+    QBENCHMARK { run(); }
+    reportPerLine(lineCount, run);
+}
+
+void tst_FossilBench::parseRevisionCommentLine()
+{
+    // The recorded outputs hold too few comment lines, always synthesize them.
+    // Each of the lines is parsed, the last one wins.
+    QFETCH(int, lineCount);
+    const QByteArray output = commentLines(lineCount);
+    const QString lastUser = QString("user%1").arg((lineCount - 1) % 13);
+
+    const auto run = [&output, &lastUser] {
+        QCOMPARE(OutputParser::parseRevisionInfo(output, true, true).committer, lastUser);
+    };
+    QBENCHMARK { run(); }
+    reportPerLine(lineCount, run);
+}
+
+void tst_FossilBench::parseRevisionInfo()
+{
+    // Here the line count is the number of info outputs parsed
+    QFETCH(int, lineCount);
+    QFETCH(QString, fixtureDir);
+    QByteArray output = recordedOutput(fixtureDir, "info.txt").toUtf8();
+    if (output.isEmpty())
+        output = revisionInfoOutput().toUtf8();
+    const int outputLineCount = output.count('\n');
+    const bool infoHash = output.contains("\nhash: ");
+
+    const auto run = [&output, infoHash, lineCount] {
+        for (int i = 0; i < lineCount; ++i)
+            QVERIFY(!OutputParser::parseRevisionInfo(output, infoHash, true).id.isEmpty());
+    };
+    QBENCHMARK { run(); }
+    reportPerLine(lineCount * outputLineCount, run);
+}
+
+void tst_FossilBench::logHighlighter()
+{
+    QFETCH(int, lineCount);
+    QFETCH(QString, fixtureDir);
+    QString output = recordedOutput(fixtureDir, "timeline.txt");
+    if (output.isEmpty())
+        output = timelineOutput(lineCount / 2);
+    QTextDocument document;
+    document.setPlainText(output);
+    auto highlighter = new FossilLogHighlighter(&document);
+
+    const auto run = [highlighter] { highlighter->rehighlight(); };
+    QBENCHMARK { run(); }
+    reportPerLine(document.blockCount(), run);
+}
+
+void tst_FossilBench::annotationHighlighter()
+{
+    QFETCH(int, lineCount);
+    QFETCH(QString, fixtureDir);
+    VcsBase::BaseAnnotationHighlighter::ChangeNumbers changes;
+    QString output = recordedOutput(fixtureDir, "annotate.txt");
+    if (output.isEmpty()) {
+        output = annotateOutput(lineCount, &changes);
+    } else {
+        for (const QString &line : output.split('\n', QString::SkipEmptyParts))
+            changes.insert(line.section(' ', 0, 0));
+    }
+    QTextDocument document;
+    document.setPlainText(output);
+    auto highlighter = new FossilAnnotationHighlighter(changes, &document);
+
+    const auto run = [highlighter] { highlighter->rehighlight(); };
+    QBENCHMARK { run(); }
+    reportPerLine(document.blockCount(), run);
+}
+
+QTEST_MAIN(tst_FossilBench)
+
+#include "tst_fossil_bench.moc"